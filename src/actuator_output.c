@@ -0,0 +1,259 @@
+/**
+ * @file actuator_output.c
+ * @brief Actuator GPIO output layer with per-port masked writes
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/sys/printk.h>
+#include "actuator_output.h"
+
+/* Actuator GPIO definitions from device tree aliases, indexed by id.
+ * Every actuator needs its own pin: led0 is the mode LED. */
+static const struct gpio_dt_spec outputs[ACTUATOR_COUNT] = {
+    [ACTUATOR_FAN]        = GPIO_DT_SPEC_GET(DT_ALIAS(fan_actuator), gpios),
+    [ACTUATOR_IRRIGATION] = GPIO_DT_SPEC_GET(DT_ALIAS(irrigation_actuator), gpios),
+    [ACTUATOR_LIGHT]      = GPIO_DT_SPEC_GET(DT_ALIAS(light_actuator), gpios),
+};
+
+static const char *const names[ACTUATOR_COUNT] = {
+    [ACTUATOR_FAN]        = "FAN",
+    [ACTUATOR_IRRIGATION] = "PUMP",
+    [ACTUATOR_LIGHT]      = "LIGHT",
+};
+
+/* Nominal power per output, for the energy estimate. The fan counts
+ * at full power whatever its PWM duty. */
+static const uint16_t rated_w[ACTUATOR_COUNT] = {
+    [ACTUATOR_FAN]        = 25,
+    [ACTUATOR_IRRIGATION] = 40,
+    [ACTUATOR_LIGHT]      = 60,
+};
+
+/* Outputs sharing one GPIO controller */
+typedef struct {
+    const struct device *port;
+    gpio_port_pins_t pins;      /* Pins of this group on the port */
+    gpio_port_pins_t invert;    /* Active-low pins: raw port writes skip the
+                                 * GPIO_ACTIVE_LOW handling of gpio_pin_set */
+    uint32_t members;           /* Actuator bits in this group */
+} port_group_t;
+
+static port_group_t groups[ACTUATOR_COUNT];
+static int group_count;
+static bool outputs_ready;      /* Set once every pin is configured */
+
+/* Outputs may also be switched from timer ISRs (irrigation pulses) */
+static struct k_spinlock output_lock;
+static uint32_t current_mask;
+static uint32_t port_writes;
+
+/* On-time per slot; 'epoch' is the slot's index since boot, so stale
+ * slots are recognised and reset lazily */
+typedef struct {
+    uint32_t epoch;
+    uint32_t on_ms;
+} usage_slot_t;
+
+#define HOUR_SLOTS      60
+#define HOUR_SLOT_MS    60000
+#define DAY_SLOTS       96
+#define DAY_SLOT_MS     (15 * 60000)
+
+/* Usage state (under output_lock) */
+static uint32_t switches[ACTUATOR_COUNT];
+static uint64_t on_total_ms[ACTUATOR_COUNT];
+static int64_t on_since_ms[ACTUATOR_COUNT];
+static int64_t usage_start_ms;
+static usage_slot_t hour_slots[ACTUATOR_COUNT][HOUR_SLOTS];
+static usage_slot_t day_slots[ACTUATOR_COUNT][DAY_SLOTS];
+
+/* Spreads the on-period [from, to) over the slots it covers */
+static void slots_add(usage_slot_t *slots, int count, uint32_t slot_ms,
+                      int64_t from, int64_t to)
+{
+    /* Only the last 'count' slots can still be read */
+    from = MAX(from, to - (int64_t)count * slot_ms);
+
+    while (from < to) {
+        uint32_t epoch = (uint32_t)(from / slot_ms);
+        int64_t end = MIN(to, ((int64_t)epoch + 1) * slot_ms);
+        usage_slot_t *slot = &slots[epoch % count];
+
+        if (slot->epoch != epoch) {
+            slot->epoch = epoch;
+            slot->on_ms = 0;
+        }
+        slot->on_ms += (uint32_t)(end - from);
+        from = end;
+    }
+}
+
+/* Duty over the last 'count' slots (the current one partly elapsed) */
+static uint16_t slots_duty(const usage_slot_t *slots, int count, uint32_t slot_ms,
+                           int64_t now, int64_t on_since)
+{
+    uint32_t cur = (uint32_t)(now / slot_ms);
+    uint32_t first = (cur >= (uint32_t)count - 1) ? cur - (count - 1) : 0;
+    int64_t start = MAX((int64_t)first * slot_ms, usage_start_ms);
+    uint64_t on = 0;
+
+    for (int i = 0; i < count; i++) {
+        if (slots[i].epoch >= first && slots[i].epoch <= cur) {
+            on += slots[i].on_ms;
+        }
+    }
+    if (on_since >= 0) {
+        on += (uint64_t)(now - MAX(on_since, start));
+    }
+    return (now > start) ? (uint16_t)MIN(on * 1000 / (uint64_t)(now - start), 1000) : 0;
+}
+
+/* Accounts the transitions in 'changed' to the new state 'mask' */
+static void account(uint32_t changed, uint32_t mask, int64_t now)
+{
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if ((changed & BIT(i)) == 0) {
+            continue;
+        }
+        switches[i]++;
+        if (mask & BIT(i)) {
+            on_since_ms[i] = now;
+        } else {
+            on_total_ms[i] += (uint64_t)(now - on_since_ms[i]);
+            slots_add(hour_slots[i], HOUR_SLOTS, HOUR_SLOT_MS, on_since_ms[i], now);
+            slots_add(day_slots[i], DAY_SLOTS, DAY_SLOT_MS, on_since_ms[i], now);
+        }
+    }
+}
+
+int actuator_output_init(void)
+{
+    outputs_ready = false;
+    group_count = 0;
+
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        const struct gpio_dt_spec *out = &outputs[i];
+        int g, ret;
+
+        if (!gpio_is_ready_dt(out)) {
+            printk("Actuator %d GPIO not ready\n", i);
+            return -ENODEV;
+        }
+        ret = gpio_pin_configure_dt(out, GPIO_OUTPUT_INACTIVE);
+        if (ret != 0) {
+            printk("Actuator %d GPIO configuration failed: %d\n", i, ret);
+            return ret;
+        }
+
+        for (g = 0; g < group_count; g++) {
+            if (groups[g].port == out->port) {
+                break;
+            }
+        }
+        if (g == group_count) {
+            groups[g].port = out->port;
+            groups[g].pins = 0;
+            groups[g].invert = 0;
+            groups[g].members = 0;
+            group_count++;
+        }
+        groups[g].pins |= BIT(out->pin);
+        if (out->dt_flags & GPIO_ACTIVE_LOW) {
+            groups[g].invert |= BIT(out->pin);
+        }
+        groups[g].members |= BIT(i);
+    }
+
+    current_mask = 0;
+    outputs_ready = true;
+    usage_start_ms = k_uptime_get();
+    printk("Actuators: %d outputs on %d port(s)\n", ACTUATOR_COUNT, group_count);
+    return 0;
+}
+
+uint32_t actuator_output_apply(uint32_t mask, uint32_t which)
+{
+    uint32_t changed;
+    k_spinlock_key_t key = k_spin_lock(&output_lock);
+
+    if (!outputs_ready) {
+        k_spin_unlock(&output_lock, key);
+        return 0;
+    }
+
+    which &= BIT_MASK(ACTUATOR_COUNT);
+    mask = (current_mask & ~which) | (mask & which);
+    changed = mask ^ current_mask;
+
+    for (int g = 0; g < group_count && changed; g++) {
+        const port_group_t *grp = &groups[g];
+        gpio_port_value_t value = 0;
+
+        if ((changed & grp->members) == 0) {
+            continue;
+        }
+
+        /* Whole group in one write: the cached state of the other
+         * members is rewritten unchanged, so nothing glitches */
+        for (int i = 0; i < ACTUATOR_COUNT; i++) {
+            if ((grp->members & mask & BIT(i)) != 0) {
+                value |= BIT(outputs[i].pin);
+            }
+        }
+        gpio_port_set_masked(grp->port, grp->pins, value ^ grp->invert);
+        port_writes++;
+    }
+
+    if (changed) {
+        account(changed, mask, k_uptime_get());
+    }
+    current_mask = mask;
+    k_spin_unlock(&output_lock, key);
+    return changed;
+}
+
+bool actuator_output_set(actuator_id_t id, bool on)
+{
+    return actuator_output_apply(on ? BIT(id) : 0, BIT(id)) != 0;
+}
+
+void actuator_output_get_usage(actuator_id_t id, actuator_usage_t *out)
+{
+    if (id >= ACTUATOR_COUNT) {
+        return;
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&output_lock);
+    int64_t now = k_uptime_get();
+    int64_t on_since = (current_mask & BIT(id)) ? on_since_ms[id] : -1;
+
+    out->switches = switches[id];
+    out->on_ms = on_total_ms[id] + ((on_since >= 0) ? (uint64_t)(now - on_since) : 0);
+    out->duty_1h_permille = slots_duty(hour_slots[id], HOUR_SLOTS, HOUR_SLOT_MS, now, on_since);
+    out->duty_24h_permille = slots_duty(day_slots[id], DAY_SLOTS, DAY_SLOT_MS, now, on_since);
+    k_spin_unlock(&output_lock, key);
+
+    out->rated_w = rated_w[id];
+    out->energy_wh = (float)out->on_ms * rated_w[id] / 3600000.0f;
+}
+
+const char *actuator_name(actuator_id_t id)
+{
+    return (id < ACTUATOR_COUNT) ? names[id] : "?";
+}
+
+uint32_t actuator_output_get(void)
+{
+    return current_mask;
+}
+
+int actuator_output_port_count(void)
+{
+    return group_count;
+}
+
+uint32_t actuator_output_port_writes(void)
+{
+    return port_writes;
+}
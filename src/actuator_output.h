@@ -0,0 +1,67 @@
+/**
+ * @file actuator_output.h
+ * @brief Actuator GPIO output layer with per-port masked writes
+ *
+ * Actuator pins come from devicetree aliases. At init they are grouped
+ * by GPIO controller, and every update writes each affected port once
+ * with gpio_port_set_masked, so actuators sharing a port switch together
+ * and unchanged ports are not touched at all. Active-low pins are
+ * inverted here, as gpio_pin_set_dt would.
+ */
+
+#ifndef ACTUATOR_OUTPUT_H
+#define ACTUATOR_OUTPUT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* Actuator ids; bit n of an actuator mask is actuator n */
+typedef enum {
+    ACTUATOR_FAN = 0,
+    ACTUATOR_IRRIGATION,
+    ACTUATOR_LIGHT,
+    ACTUATOR_COUNT
+} actuator_id_t;
+
+/* Configures all actuator pins inactive and builds the port groups.
+ * Returns -ENODEV if a pin is not ready or the configure error;
+ * nothing is driven until an init succeeds. */
+int actuator_output_init(void);
+
+/* Drives the outputs selected by 'which' to their bit in 'mask' and
+ * leaves the others alone; returns the bits that changed (none before
+ * a successful init). Safe from ISRs (a spinlock covers the cache and
+ * the port writes). */
+uint32_t actuator_output_apply(uint32_t mask, uint32_t which);
+
+/* Switches one output; returns true if it changed */
+bool actuator_output_set(actuator_id_t id, bool on);
+
+/*
+ * Usage accounting, folded in on each transition (no periodic work):
+ * total on-time and switches since boot, and rolling duty cycles kept
+ * in slot rings (60 x 1 min for 1 h, 96 x 15 min for 24 h) that are
+ * only touched when an on-period ends or the usage is read.
+ */
+typedef struct {
+    uint32_t switches;
+    uint64_t on_ms;
+    uint16_t duty_1h_permille;
+    uint16_t duty_24h_permille;
+    uint16_t rated_w;               /* Nominal power draw */
+    float energy_wh;                /* on_ms at the rated power */
+} actuator_usage_t;
+
+void actuator_output_get_usage(actuator_id_t id, actuator_usage_t *out);
+
+/* Short name of an actuator ("FAN", "PUMP", "LIGHT") */
+const char *actuator_name(actuator_id_t id);
+
+/* Mask currently driven */
+uint32_t actuator_output_get(void);
+
+/* Number of port groups and driver writes issued, for diagnostics */
+int actuator_output_port_count(void);
+uint32_t actuator_output_port_writes(void);
+
+#endif /* ACTUATOR_OUTPUT_H */
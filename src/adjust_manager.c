@@ -1,80 +1,983 @@
 #include <zephyr/sys/printk.h>
-#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/pwm.h>
+#include <zephyr/settings/settings.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "adjust_manager.h"
 #include "mode_controller.h"
 #include "env_controller.h"
+#include "app_channels.h"
+#include "actuator_output.h"
+#include "pid_ctrl.h"
+#include "autotune.h"
+#include "irrigation.h"
+#include "rule_engine.h"
+#include "trend.h"
 
-/* Actuator GPIO definitions from device tree aliases */
-#define FAN_NODE          DT_ALIAS(fan_actuator)
-#define IRRIGATION_NODE   DT_ALIAS(irrigation_actuator)
-#define LIGHT_NODE        DT_ALIAS(led0)   /* Onboard LED already exists */
+/* Serializes evaluations from the sensor loop and the Bluetooth thread */
+K_MUTEX_DEFINE(actuator_lock);
 
-static const struct gpio_dt_spec fan_gpio =
-        GPIO_DT_SPEC_GET(FAN_NODE, gpios);
+/* Trigger-to-pin latency of actual transitions (under actuator_lock) */
+static adjust_latency_t latency;
+static uint64_t latency_sum_us;
 
-static const struct gpio_dt_spec irrigation_gpio =
-        GPIO_DT_SPEC_GET(IRRIGATION_NODE, gpios);
+/*
+ * Switching policy per actuator: the output turns on once the error
+ * exceeds +deadband and off once it drops below -deadband, and each
+ * state is held at least its minimum time before the next switch.
+ */
+typedef struct {
+    float deadband;             /* Half-width around the setpoint */
+    uint32_t min_on_ms;
+    uint32_t min_off_ms;
+} actuator_policy_t;
 
-static const struct gpio_dt_spec light_gpio =
-        GPIO_DT_SPEC_GET(LIGHT_NODE, gpios);
+static const actuator_policy_t policies[ACTUATOR_COUNT] = {
+    [ACTUATOR_FAN]        = { .deadband = 0.5f,  .min_on_ms = 30000, .min_off_ms = 30000 },
+    [ACTUATOR_IRRIGATION] = { .deadband = 3.0f,  .min_on_ms = 10000, .min_off_ms = 60000 },
+    [ACTUATOR_LIGHT]      = { .deadband = 25.0f, .min_on_ms = 10000, .min_off_ms = 10000 },
+};
 
-/* Initializes actuator GPIO pins */
-static void adjust_manager_init_actuators(void)
+/* Channel each actuator acts on; a stale one forces the actuator off */
+static const sensor_ch_t actuator_input[ACTUATOR_COUNT] = {
+    [ACTUATOR_FAN]        = SENSOR_CH_TEMPERATURE,
+    [ACTUATOR_IRRIGATION] = SENSOR_CH_HUMIDITY,
+    [ACTUATOR_LIGHT]      = SENSOR_CH_LIGHT,
+};
+
+/* False when the outputs failed to initialise: nothing is evaluated */
+static bool actuation_enabled;
+
+/* Switching state and counters (under actuator_lock) */
+static int64_t last_switch_ms[ACTUATOR_COUNT];
+static uint32_t hold_pending;           /* Actuators waiting out a minimum time */
+static uint32_t stale_safe;             /* Actuators held off for a stale input */
+static adjust_counters_t counters[ACTUATOR_COUNT];
+
+/* Re-evaluates when a held transition becomes allowed, so a switch is
+ * not delayed until the next published change */
+static void hold_work_handler(struct k_work *work)
+{
+    adjust_manager_update_actuators();
+}
+
+static K_WORK_DELAYABLE_DEFINE(hold_work, hold_work_handler);
+
+/*
+ * Fan speed PID. Input is the temperature in m°C, output the PWM duty
+ * in permille. Gains are given in user units (% duty per °C, per °C·s
+ * and per °C/s); one user unit is 10 permille per 1000 m°C.
+ */
+#define FAN_PWM_NODE        DT_ALIAS(fan_pwm)
+#if DT_NODE_HAS_STATUS(FAN_PWM_NODE, okay) && defined(CONFIG_PWM)
+#define HAVE_FAN_PWM        1
+static const struct pwm_dt_spec fan_pwm = PWM_DT_SPEC_GET(FAN_PWM_NODE);
+#else
+#define HAVE_FAN_PWM        0
+#endif
+
+#define FAN_PID_KP          20.0f       /* % per °C */
+#define FAN_PID_KI          0.05f       /* % per °C·s */
+#define FAN_PID_KD          30.0f       /* % per °C/s */
+#define PID_MIN_DT_MS       500         /* Steps faster than this are skipped */
+#define PID_GAIN_TO_Q16(g)  PID_TO_Q16((g) / 100.0f)
+
+static pid_ctrl_t fan_pid;
+static bool fan_pid_enabled;
+static float fan_gains[3] = { FAN_PID_KP, FAN_PID_KI, FAN_PID_KD };
+
+/* Irrigation gains (% duty per %RH, per %RH·s, per %RH/s), set by
+ * auto-tuning */
+static float pump_gains[3] = { 10.0f, 0.02f, 0.0f };
+static uint32_t gains_stored;           /* BIT(actuator) loaded from / saved to flash */
+
+/* Irrigation: time-proportioned pulses from a PI on humidity (default),
+ * or plain on/off through the deadband policy */
+static bool irrigation_tp = true;
+static pid_ctrl_t pump_pid;
+static int64_t pump_pid_last_ms;
+
+/*
+ * Coordinated fan/pump control. Ventilation also dries the air, so with
+ * independent loops the pump chases a humidity drop the fan caused and
+ * the two run together. In coordinated mode temperature has priority:
+ * the pump yields while the fan vents and for COORD_SETTLE_MS after it
+ * stops (the air recovers on its own), and a dry greenhouse tolerates a
+ * wider band above the temperature target before the fan starts. Below
+ * COORD_HUM_CRITICAL under the target the pump never yields. A PID fan
+ * only counts as venting from COORD_VENT_DUTY up: it idles at a low
+ * duty most of the time, which barely moves the humidity.
+ */
+#define COORD_HUM_CRITICAL  6.0f        /* %RH below target */
+#define COORD_VENT_DUTY     300         /* Permille */
+#define COORD_SETTLE_MS     120000
+#define COORD_FAN_DRY_BAND  1.5f        /* °C, fan on-threshold when dry */
+
+static bool coord_enabled = true;
+static int64_t coord_vent_end_ms;
+static int64_t coord_last_ms;
+static uint64_t coord_yield_ms;
+static uint64_t coord_defer_ms;
+static uint64_t coord_run_ms[2];        /* Indexed by coord_enabled */
+static uint64_t coord_on_ms[2];         /* Fan + pump on-time */
+
+/*
+ * Feed-forward: the fan and pump loops act on the temperature and
+ * humidity forecast FF_HORIZON_S ahead (sliding-window regression)
+ * instead of the current reading, so a fast rise is met before it
+ * crosses the target. Excursions above the temperature target are
+ * accounted per mode to compare the two.
+ */
+#define FF_HORIZON_S        180
+
+static bool feed_forward;
+static int64_t over_last_ms;
+static uint64_t over_run_ms[2];         /* Indexed by feed_forward */
+static uint64_t over_ms[2];             /* Time above target + fan deadband */
+static float over_max[2];               /* Largest excursion above target */
+
+/* Relay auto-tuning; the tuned actuator leaves normal control */
+#define TUNE_HYST_FAN       0.2f        /* °C */
+#define TUNE_HYST_PUMP      1.0f        /* %RH */
+
+static autotune_t tune;
+static actuator_id_t tune_target;
+static uint32_t fan_duty;               /* Permille */
+static int64_t fan_pid_last_ms;
+
+/* Temperature step response: a setpoint change starts a measurement
+ * that ends once the temperature stays within the band long enough */
+#define STEP_BAND_MC        500
+#define STEP_HOLD_MS        60000
+
+static adjust_step_response_t step_result;
+static bool step_active;
+static int64_t step_start_ms;
+static int64_t step_in_band_ms;
+static int32_t step_sp_mc;
+static int32_t step_dir;                /* +1 heating towards sp, -1 cooling */
+static bool step_sp_known;
+
+static float *gains_of(actuator_id_t id)
+{
+    return (id == ACTUATOR_FAN) ? fan_gains : pump_gains;
+}
+
+static pid_ctrl_t *pid_of(actuator_id_t id)
+{
+    return (id == ACTUATOR_FAN) ? &fan_pid : &pump_pid;
+}
+
+#ifdef CONFIG_SETTINGS
+/* Gains live under "gains/fan" and "gains/pump" (3 floats each) */
+static int gains_settings_set(const char *name, size_t len,
+                              settings_read_cb read_cb, void *cb_arg)
+{
+    actuator_id_t id;
+    const char *next;
+    float g[3];
+    int rc;
+
+    if (settings_name_steq(name, "fan", &next) && !next) {
+        id = ACTUATOR_FAN;
+    } else if (settings_name_steq(name, "pump", &next) && !next) {
+        id = ACTUATOR_IRRIGATION;
+    } else {
+        return -ENOENT;
+    }
+
+    if (len != sizeof(g)) {
+        return -EINVAL;
+    }
+    rc = read_cb(cb_arg, g, sizeof(g));
+    if (rc < 0) {
+        return rc;
+    }
+
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    memcpy(gains_of(id), g, sizeof(g));
+    pid_set_gains(pid_of(id), PID_GAIN_TO_Q16(g[0]), PID_GAIN_TO_Q16(g[1]),
+                  PID_GAIN_TO_Q16(g[2]));
+    gains_stored |= BIT(id);
+    k_mutex_unlock(&actuator_lock);
+
+    printk("Loaded %s gains: %.2f %.3f %.2f\n", actuator_name(id),
+           (double)g[0], (double)g[1], (double)g[2]);
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(gains, "gains", NULL, gains_settings_set, NULL, NULL);
+#endif
+
+/* Flash writes happen on the system work queue, never under the lock */
+static uint32_t gains_dirty;
+
+static void gains_save_work_handler(struct k_work *work)
 {
-    gpio_pin_configure_dt(&fan_gpio, GPIO_OUTPUT_INACTIVE);
-    gpio_pin_configure_dt(&irrigation_gpio, GPIO_OUTPUT_INACTIVE);
-    gpio_pin_configure_dt(&light_gpio, GPIO_OUTPUT_INACTIVE);
+#ifdef CONFIG_SETTINGS
+    float g[3];
+    uint32_t dirty;
+
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    dirty = gains_dirty;
+    gains_dirty = 0;
+    k_mutex_unlock(&actuator_lock);
+
+    for (int id = 0; id < ACTUATOR_COUNT; id++) {
+        if ((dirty & BIT(id)) == 0) {
+            continue;
+        }
+
+        k_mutex_lock(&actuator_lock, K_FOREVER);
+        memcpy(g, gains_of((actuator_id_t)id), sizeof(g));
+        k_mutex_unlock(&actuator_lock);
+
+        int rc = settings_save_one(id == ACTUATOR_FAN ? "gains/fan" : "gains/pump",
+                                   g, sizeof(g));
+        if (rc == 0) {
+            k_mutex_lock(&actuator_lock, K_FOREVER);
+            gains_stored |= BIT(id);
+            k_mutex_unlock(&actuator_lock);
+        } else {
+            printk("Saving %s gains failed: %d\n", actuator_name((actuator_id_t)id), rc);
+        }
+    }
+#endif
+}
+
+static K_WORK_DEFINE(gains_save_work, gains_save_work_handler);
+
+/* Call with actuator_lock held */
+static void store_gains(actuator_id_t id, const float g[3])
+{
+    memcpy(gains_of(id), g, 3 * sizeof(float));
+    pid_set_gains(pid_of(id), PID_GAIN_TO_Q16(g[0]), PID_GAIN_TO_Q16(g[1]),
+                  PID_GAIN_TO_Q16(g[2]));
+    gains_dirty |= BIT(id);
+    k_work_submit(&gains_save_work);
 }
 
 /* Call this ONCE from env_controller_init or main */
-void adjust_manager_init(void)
+int adjust_manager_init(void)
+{
+    int64_t now = k_uptime_get();
+    int ret;
+
+    /* Without every pin the controller stays passive: no evaluation,
+     * no PWM, and the output layer drives nothing */
+    ret = actuator_output_init();
+    actuation_enabled = (ret == 0);
+
+    /* Outputs start off and may switch on right away */
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        last_switch_ms[i] = now - policies[i].min_off_ms;
+    }
+
+    pid_params_t params = {
+        .kp = PID_GAIN_TO_Q16(fan_gains[0]),
+        .ki = PID_GAIN_TO_Q16(fan_gains[1]),
+        .kd = PID_GAIN_TO_Q16(fan_gains[2]),
+        .d_alpha = PID_TO_Q16(0.3f),
+        .out_min = 0,
+        .out_max = 1000,
+        .reverse = true,        /* Fan speeds up when it is too warm */
+    };
+    pid_init(&fan_pid, &params);
+
+    params.kp = PID_GAIN_TO_Q16(pump_gains[0]);
+    params.ki = PID_GAIN_TO_Q16(pump_gains[1]);
+    params.kd = PID_GAIN_TO_Q16(pump_gains[2]);
+    params.reverse = false;     /* Pump runs longer when it is too dry */
+    pid_init(&pump_pid, &params);
+
+#if HAVE_FAN_PWM
+    fan_pid_enabled = actuation_enabled && pwm_is_ready_dt(&fan_pwm);
+    if (fan_pid_enabled) {
+        pwm_set_pulse_dt(&fan_pwm, 0);
+    }
+#endif
+    if (!actuation_enabled) {
+        printk("Actuation disabled: actuator outputs unavailable (%d)\n", ret);
+        return ret;
+    }
+    printk("Fan control: %s\n", fan_pid_enabled ? "PID (PWM)" : "on/off");
+    return 0;
+}
+
+static void set_fan_duty(uint32_t duty)
 {
-    adjust_manager_init_actuators();
+#if HAVE_FAN_PWM
+    if (duty != fan_duty) {
+        pwm_set_pulse_dt(&fan_pwm, (uint32_t)((uint64_t)fan_pwm.period * duty / 1000));
+    }
+#endif
+    fan_duty = duty;
 }
 
-/* Core actuator control logic */
-void adjust_manager_update_actuators(void)
+/* Runs a PID step at most every PID_MIN_DT_MS; returns false if skipped */
+static bool run_pid(pid_ctrl_t *pid, int64_t *last_ms, float setpoint, float value,
+                    int64_t now, uint32_t *out)
 {
-    env_measurements_t m;
-    env_setpoints_t sp;
+    int64_t dt = (*last_ms == 0) ? PID_MIN_DT_MS : now - *last_ms;
+
+    if (dt < PID_MIN_DT_MS) {
+        return false;
+    }
+    *last_ms = now;
 
-    /* Read shared state safely */
-    k_mutex_lock(&env.lock, K_FOREVER);
-    m = env.measurements;
-    sp = env.setpoints;
-    k_mutex_unlock(&env.lock);
+    *out = (uint32_t)pid_update(pid, (int32_t)(setpoint * 1000.0f),
+                                (int32_t)(value * 1000.0f), (uint32_t)dt);
+    return true;
+}
+
+/* Restarts both loops from a clean state (after tuning or mode changes) */
+static void reset_pids(void)
+{
+    pid_reset(&fan_pid);
+    pid_reset(&pump_pid);
+    fan_pid_last_ms = 0;
+    pump_pid_last_ms = 0;
+}
 
-    /* --- LIGHT CONTROL using onboard LED --- */
-    if (m.light < sp.target_light) {
-        gpio_pin_set_dt(&light_gpio, 1);   /* Light is too low */
+/* Whether the pump has to hold back its demand for the ventilation */
+static bool pump_yields(const env_state_t *st, bool venting, int64_t now)
+{
+    float dry = st->setpoints.target_humidity - st->measurements.humidity;
+
+    if (venting) {
+        coord_vent_end_ms = now + COORD_SETTLE_MS;
+    }
+    if (!coord_enabled || dry > COORD_HUM_CRITICAL) {
+        return false;
+    }
+    return venting || now < coord_vent_end_ms;
+}
+
+/* Accounts the time since the last evaluation to the active mode;
+ * 'current' is the output state during that time */
+static void coord_account(uint32_t current, bool yield, bool defer, int64_t now)
+{
+    int64_t dt = (coord_last_ms == 0) ? 0 : now - coord_last_ms;
+    int on = ((current & APP_ACTUATOR_FAN) ? 1 : 0) +
+             ((current & APP_ACTUATOR_IRRIGATION) ? 1 : 0);
+
+    coord_last_ms = now;
+    coord_run_ms[coord_enabled] += (uint64_t)dt;
+    coord_on_ms[coord_enabled] += (uint64_t)(dt * on);
+    if (yield) {
+        coord_yield_ms += (uint64_t)dt;
+    }
+    if (defer) {
+        coord_defer_ms += (uint64_t)dt;
+    }
+}
+
+/* Measurements the loops act on: the forecast in feed-forward mode
+ * (where a trend is available), else the readings */
+static void control_inputs(const env_state_t *st, env_measurements_t *out)
+{
+    trend_info_t t;
+
+    *out = st->measurements;
+    if (!feed_forward) {
+        return;
+    }
+    if (trend_get(SENSOR_CH_TEMPERATURE, FF_HORIZON_S, &t) == 0) {
+        out->temperature = t.forecast;
+    }
+    if (trend_get(SENSOR_CH_HUMIDITY, FF_HORIZON_S, &t) == 0) {
+        out->humidity = t.forecast;
+    }
+}
+
+/* Accounts temperature excursions above target to the active mode */
+static void overshoot_account(const env_state_t *st, int64_t now)
+{
+    float over = st->measurements.temperature - st->setpoints.target_temperature;
+    int64_t dt = (over_last_ms == 0) ? 0 : now - over_last_ms;
+
+    over_last_ms = now;
+    over_run_ms[feed_forward] += (uint64_t)dt;
+    if (over > policies[ACTUATOR_FAN].deadband) {
+        over_ms[feed_forward] += (uint64_t)dt;
+    }
+    over_max[feed_forward] = MAX(over_max[feed_forward], over);
+}
+
+/* Follows the temperature after setpoint steps (settling time, overshoot) */
+static void track_step_response(const env_state_t *st, int64_t now)
+{
+    int32_t sp = (int32_t)(st->setpoints.target_temperature * 1000.0f);
+    int32_t t = (int32_t)(st->measurements.temperature * 1000.0f);
+
+    if (!step_sp_known || sp != step_sp_mc) {
+        if (step_sp_known) {
+            step_active = true;
+            step_start_ms = now;
+            step_in_band_ms = -1;
+            step_dir = (sp > t) ? 1 : -1;
+            step_result = (adjust_step_response_t){ .pid = fan_pid_enabled,
+                                                    .ff = feed_forward };
+        }
+        step_sp_mc = sp;
+        step_sp_known = true;
+    }
+
+    if (!step_active) {
+        return;
+    }
+
+    /* Excursion past the setpoint in the direction of travel */
+    int32_t past = (t - sp) * step_dir;
+    if (past > step_result.overshoot_mc) {
+        step_result.overshoot_mc = past;
+    }
+
+    if (abs(t - sp) <= STEP_BAND_MC) {
+        if (step_in_band_ms < 0) {
+            step_in_band_ms = now;
+        } else if (now - step_in_band_ms >= STEP_HOLD_MS) {
+            step_result.settled = true;
+            step_result.settle_ms = (uint32_t)(step_in_band_ms - step_start_ms);
+            step_active = false;
+        }
     } else {
-        gpio_pin_set_dt(&light_gpio, 0);
+        step_in_band_ms = -1;
+    }
+}
+
+static void record_latency(uint32_t trigger_cycles)
+{
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - trigger_cycles);
+
+    latency.transitions++;
+    latency_sum_us += us;
+    latency.avg_us = (uint32_t)(latency_sum_us / latency.transitions);
+    if (us > latency.max_us) {
+        latency.max_us = us;
+    }
+    if (us > ADJUST_LATENCY_BUDGET_US) {
+        latency.over_budget++;
+    }
+}
+
+/* Error of an actuator's controlled quantity, positive = wants on */
+static float actuator_error(actuator_id_t id, const env_measurements_t *m,
+                            const env_setpoints_t *sp)
+{
+    switch (id) {
+    case ACTUATOR_FAN:          /* Temperature too high */
+        return m->temperature - sp->target_temperature;
+    case ACTUATOR_IRRIGATION:   /* Humidity too low */
+        return sp->target_humidity - m->humidity;
+    case ACTUATOR_LIGHT:        /* Light too low */
+        return sp->target_light - m->light;
+    default:
+        return 0.0f;
+    }
+}
+
+/* Evaluates the thresholds; 'trigger_cycles' is when the sensor sample
+ * or command behind this evaluation happened */
+static void update_actuators(uint32_t trigger_cycles)
+{
+    env_state_t st;
+    uint32_t current, mask, changed;
+    int64_t now, wait_ms = -1;
+
+    if (!actuation_enabled) {
+        return;
+    }
+
+    /* Lock-free snapshot of the shared state */
+    env_controller_read(&st);
+
+    /* Called from the evaluation and hold work and the Bluetooth commands */
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+
+    now = k_uptime_get();
+    current = actuator_output_get();
+    mask = current;
+
+    track_step_response(&st, now);
+    overshoot_account(&st, now);
+
+    /* What the fan and pump loops see (the forecast in feed-forward) */
+    env_measurements_t ctl;
+
+    control_inputs(&st, &ctl);
+
+    /* Actuators driven directly, outside the deadband/min-time policy */
+    uint32_t direct = 0;
+
+    /* No control on a stale reading: the actuator goes to its safe
+     * state, off, right away (minimum on-times do not apply) */
+    uint32_t safe = 0;
+
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if (st.measurements.stale & BIT(actuator_input[i])) {
+            safe |= BIT(i);
+        }
+    }
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if ((safe & ~stale_safe) & BIT(i)) {
+            counters[i].stale_off++;
+            printk("%s input stale, switched off\n", actuator_name((actuator_id_t)i));
+        }
+    }
+    stale_safe = safe;
+    mask &= ~safe;
+    direct |= safe;
+
+    if (tune.state == AUTOTUNE_RUNNING && (safe & BIT(tune_target))) {
+        autotune_stop(&tune);
+        reset_pids();
+        printk("Auto-tune %s stopped: input stale\n", actuator_name(tune_target));
+    }
+    if ((safe & APP_ACTUATOR_FAN) && fan_pid_enabled) {
+        set_fan_duty(0);
+        pid_reset(&fan_pid);
+        fan_pid_last_ms = 0;
+    }
+    if (safe & APP_ACTUATOR_IRRIGATION) {
+        pid_reset(&pump_pid);
+        pump_pid_last_ms = 0;
+    }
+
+    if (tune.state == AUTOTUNE_RUNNING) {
+        float value = (tune_target == ACTUATOR_FAN) ? st.measurements.temperature
+                                                    : st.measurements.humidity;
+        bool on = autotune_step(&tune, value, now);
+
+        direct |= BIT(tune_target);
+        mask = on ? (mask | BIT(tune_target)) : (mask & ~BIT(tune_target));
+        /* An on/off fan keeps its full duty and follows the mask; in PID
+         * mode the loop takes the duty back once the run ends */
+        if (tune_target == ACTUATOR_FAN && fan_pid_enabled) {
+            set_fan_duty(on ? 1000 : 0);
+        }
+
+        if (tune.state == AUTOTUNE_DONE) {
+            printk("Auto-tune %s: Ku=%.2f Pu=%.0fs -> %.2f %.3f %.2f\n",
+                   actuator_name(tune_target), (double)tune.ku, (double)tune.pu_s,
+                   (double)tune.gains[0], (double)tune.gains[1], (double)tune.gains[2]);
+            store_gains(tune_target, tune.gains);
+            reset_pids();
+        } else if (tune.state == AUTOTUNE_FAILED) {
+            printk("Auto-tune %s failed, gains unchanged\n", actuator_name(tune_target));
+        }
+    }
+
+    /* User rules override the built-in control, not an auto-tune run */
+    rule_result_t rules;
+
+    rule_engine_eval(&st, now, &rules);
+    rules.mask &= ~direct;
+    if (rules.mask) {
+        mask = (mask & ~rules.mask) | (rules.on & rules.mask);
+        direct |= rules.mask;
+        if ((rules.mask & APP_ACTUATOR_FAN) && fan_pid_enabled) {
+            set_fan_duty((rules.on & APP_ACTUATOR_FAN) ? 1000 : 0);
+        }
+    }
+    if (rules.wait_ms >= 0) {
+        wait_ms = rules.wait_ms;
+    }
+
+    /* With the PID the fan enable simply follows the duty */
+    if (fan_pid_enabled && (direct & APP_ACTUATOR_FAN) == 0) {
+        uint32_t duty;
+
+        if (run_pid(&fan_pid, &fan_pid_last_ms, st.setpoints.target_temperature,
+                    ctl.temperature, now, &duty)) {
+            set_fan_duty(duty);
+        }
+        mask = (fan_duty > 0) ? (mask | APP_ACTUATOR_FAN) : (mask & ~APP_ACTUATOR_FAN);
+        direct |= APP_ACTUATOR_FAN;
+    }
+
+    /* An on/off fan is decided below, so its state from the previous
+     * evaluation stands in; that lag is far below its minimum times */
+    bool venting = (mask & APP_ACTUATOR_FAN) != 0 &&
+                   (!fan_pid_enabled || fan_duty >= COORD_VENT_DUTY);
+    bool pump_yield = pump_yields(&st, venting, now);
+    bool fan_defer = false;
+
+    /* Time-proportioned irrigation: the PI sets the on-fraction, the
+     * irrigation timers own the pump pin */
+    uint32_t timed = 0;
+    bool pump_timed = irrigation_tp && (direct & APP_ACTUATOR_IRRIGATION) == 0;
+
+    if (pump_timed) {
+        uint32_t fraction;
+
+        if (pump_yield) {
+            /* Integral frozen while yielding, not wound up */
+            irrigation_set_fraction(0);
+            pump_pid_last_ms = now;
+        } else if (run_pid(&pump_pid, &pump_pid_last_ms, st.setpoints.target_humidity,
+                           ctl.humidity, now, &fraction)) {
+            /* Fraction first: enabling fires the first window right away */
+            irrigation_set_fraction(fraction);
+        }
+        direct |= APP_ACTUATOR_IRRIGATION;
+        timed |= APP_ACTUATOR_IRRIGATION;
+    }
+    irrigation_enable(pump_timed);
+    irrigation_track(st.measurements.humidity, st.setpoints.target_humidity, now);
+
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        const actuator_policy_t *pol = &policies[i];
+
+        if (direct & BIT(i)) {
+            continue;
+        }
+        float err = actuator_error((actuator_id_t)i, &ctl, &st.setpoints);
+        float on_band = pol->deadband;
+        bool on = (current & BIT(i)) != 0;
+        bool want = on;
+
+        if (i == ACTUATOR_FAN && coord_enabled &&
+            st.measurements.humidity < st.setpoints.target_humidity) {
+            on_band = MAX(on_band, COORD_FAN_DRY_BAND);
+            fan_defer = !on && err > pol->deadband && err <= on_band;
+        }
+
+        /* Inside the deadband the actuator keeps its state */
+        if (err > on_band) {
+            want = true;
+        } else if (err < -pol->deadband) {
+            want = false;
+        }
+        if (i == ACTUATOR_IRRIGATION && pump_yield) {
+            want = false;
+        }
+
+        if (want == on) {
+            hold_pending &= ~BIT(i);
+            continue;
+        }
+
+        int64_t min_ms = on ? pol->min_on_ms : pol->min_off_ms;
+        int64_t left = last_switch_ms[i] + min_ms - now;
+
+        if (left > 0) {
+            /* Too early: count the held transition once, retry later */
+            if ((hold_pending & BIT(i)) == 0) {
+                counters[i].held++;
+                hold_pending |= BIT(i);
+            }
+            if (wait_ms < 0 || left < wait_ms) {
+                wait_ms = left;
+            }
+            continue;
+        }
+
+        hold_pending &= ~BIT(i);
+        mask ^= BIT(i);
+    }
+
+    coord_account(current, pump_yield, fan_defer, now);
+
+    /* Only ports with a changed actuator are written */
+    changed = actuator_output_apply(mask, ~timed);
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if (changed & BIT(i)) {
+            last_switch_ms[i] = now;
+        }
+    }
+    if (changed) {
+        record_latency(trigger_cycles);
+    }
+
+    k_mutex_unlock(&actuator_lock);
+
+    if (wait_ms >= 0) {
+        k_work_reschedule(&hold_work, K_MSEC(wait_ms));
+    }
+
+    if (changed) {
+        app_actuator_msg_t msg = { .active = mask, .cycles = k_cycle_get_32() };
+        zbus_chan_pub(&actuator_chan, &msg, APP_CHAN_PUB_TIMEOUT);
+    }
+}
+
+int adjust_manager_set_pid_enabled(bool enable)
+{
+    if (enable && !HAVE_FAN_PWM) {
+        return -ENOTSUP;
+    }
+
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    if (enable != fan_pid_enabled) {
+        /* Start from a clean state; on/off control takes the fan back */
+        reset_pids();
+        set_fan_duty(enable ? 0 : 1000);
+        fan_pid_enabled = enable;
+    }
+    k_mutex_unlock(&actuator_lock);
+
+    adjust_manager_update_actuators();
+    return 0;
+}
+
+void adjust_manager_set_pid_gains(float kp, float ki, float kd)
+{
+    const float g[3] = { kp, ki, kd };
+
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    store_gains(ACTUATOR_FAN, g);
+    k_mutex_unlock(&actuator_lock);
+}
+
+void adjust_manager_get_pid(adjust_pid_info_t *out)
+{
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    out->available = HAVE_FAN_PWM;
+    out->enabled = fan_pid_enabled;
+    out->kp = fan_gains[0];
+    out->ki = fan_gains[1];
+    out->kd = fan_gains[2];
+    out->duty_permille = fan_duty;
+    k_mutex_unlock(&actuator_lock);
+}
+
+void adjust_manager_set_irrigation_tp(bool enable)
+{
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    if (enable != irrigation_tp) {
+        irrigation_tp = enable;
+        reset_pids();
+        /* The policy starts counting from the pump state it takes over */
+        last_switch_ms[ACTUATOR_IRRIGATION] = k_uptime_get();
+    }
+    k_mutex_unlock(&actuator_lock);
+
+    adjust_manager_update_actuators();
+}
+
+bool adjust_manager_get_irrigation_tp(void)
+{
+    return irrigation_tp;
+}
+
+void adjust_manager_set_coordinated(bool enable)
+{
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    coord_enabled = enable;
+    k_mutex_unlock(&actuator_lock);
+
+    adjust_manager_update_actuators();
+}
+
+void adjust_manager_get_coordination(adjust_coord_info_t *out)
+{
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    out->enabled = coord_enabled;
+    out->yield_s = (uint32_t)(coord_yield_ms / 1000U);
+    out->defer_s = (uint32_t)(coord_defer_ms / 1000U);
+    for (int m = 0; m < 2; m++) {
+        out->run_s[m] = (uint32_t)(coord_run_ms[m] / 1000U);
+        out->on_s_per_h[m] = (coord_run_ms[m] > 0)
+                             ? (uint32_t)(coord_on_ms[m] * 3600U / coord_run_ms[m]) : 0;
     }
+    k_mutex_unlock(&actuator_lock);
+}
 
-    /* --- TEMPERATURE CONTROL (Fan Motor) --- */
-    if (m.temperature > sp.target_temperature) {
-        gpio_pin_set_dt(&fan_gpio, 1);     /* Activate fan */
+void adjust_manager_set_feed_forward(bool enable)
+{
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    if (enable != feed_forward) {
+        feed_forward = enable;
+        /* The loops' input jumps to the forecast: restart them */
+        reset_pids();
+    }
+    k_mutex_unlock(&actuator_lock);
+
+    adjust_manager_update_actuators();
+}
+
+void adjust_manager_get_feed_forward(adjust_ff_info_t *out)
+{
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    out->enabled = feed_forward;
+    out->horizon_s = FF_HORIZON_S;
+    for (int m = 0; m < 2; m++) {
+        out->run_s[m] = (uint32_t)(over_run_ms[m] / 1000U);
+        out->over_s[m] = (uint32_t)(over_ms[m] / 1000U);
+        out->over_max[m] = over_max[m];
+    }
+    k_mutex_unlock(&actuator_lock);
+}
+
+int adjust_manager_autotune_start(actuator_id_t id)
+{
+    env_state_t st;
+    int ret = 0;
+
+    if (id != ACTUATOR_FAN && id != ACTUATOR_IRRIGATION) {
+        return -EINVAL;
+    }
+
+    env_controller_read(&st);
+
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    if (tune.state == AUTOTUNE_RUNNING) {
+        ret = -EBUSY;
+    } else if (id == ACTUATOR_FAN) {
+        autotune_start(&tune, st.setpoints.target_temperature, TUNE_HYST_FAN, true,
+                       st.measurements.temperature, k_uptime_get());
     } else {
-        gpio_pin_set_dt(&fan_gpio, 0);
+        autotune_start(&tune, st.setpoints.target_humidity, TUNE_HYST_PUMP, false,
+                       st.measurements.humidity, k_uptime_get());
+    }
+    if (ret == 0) {
+        tune_target = id;
+    }
+    k_mutex_unlock(&actuator_lock);
+
+    if (ret == 0) {
+        printk("Auto-tune %s started\n", actuator_name(id));
+        adjust_manager_update_actuators();
+    }
+    return ret;
+}
+
+void adjust_manager_autotune_stop(void)
+{
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    autotune_stop(&tune);
+    reset_pids();
+    k_mutex_unlock(&actuator_lock);
+
+    adjust_manager_update_actuators();
+}
+
+void adjust_manager_get_autotune(adjust_autotune_info_t *out)
+{
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    out->state = tune.state;
+    out->target = tune_target;
+    out->cycles = tune.cycles;
+    out->ku = tune.ku;
+    out->pu_s = tune.pu_s;
+    k_mutex_unlock(&actuator_lock);
+}
+
+bool adjust_manager_get_gains(actuator_id_t id, float gains[3])
+{
+    bool stored;
+
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    memcpy(gains, gains_of(id), 3 * sizeof(float));
+    stored = (gains_stored & BIT(id)) != 0;
+    k_mutex_unlock(&actuator_lock);
+
+    return stored;
+}
+
+int adjust_manager_get_step_response(adjust_step_response_t *out)
+{
+    int ret;
+
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    *out = step_result;
+    ret = step_active ? -EINPROGRESS : (step_sp_known && out->settled ? 0 : -ENODATA);
+    k_mutex_unlock(&actuator_lock);
+
+    return ret;
+}
+
+void adjust_manager_get_counters(actuator_id_t id, adjust_counters_t *out)
+{
+    if (id >= ACTUATOR_COUNT) {
+        return;
     }
 
-    /* --- HUMIDITY CONTROL (Irrigation Motor) --- */
-    if (m.humidity < sp.target_humidity) {
-        gpio_pin_set_dt(&irrigation_gpio, 1);  /* Activate pump */
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    *out = counters[id];
+    k_mutex_unlock(&actuator_lock);
+}
+
+/* Core actuator control logic */
+void adjust_manager_update_actuators(void)
+{
+    update_actuators(k_cycle_get_32());
+}
+
+void adjust_manager_get_latency(adjust_latency_t *out)
+{
+    k_mutex_lock(&actuator_lock, K_FOREVER);
+    *out = latency;
+    k_mutex_unlock(&actuator_lock);
+}
+
+/* Evaluation requested by the listener. Publish time and trigger are
+ * the oldest change not yet evaluated, so coalesced changes report the
+ * full wait. */
+static struct k_spinlock eval_lock;
+static uint32_t eval_publish_cycles;
+static uint32_t eval_trigger_cycles;
+static bool eval_pending;
+
+static void eval_work_handler(struct k_work *work)
+{
+    k_spinlock_key_t key = k_spin_lock(&eval_lock);
+    uint32_t published = eval_publish_cycles;
+    uint32_t trigger = eval_trigger_cycles;
+
+    eval_pending = false;
+    k_spin_unlock(&eval_lock, key);
+
+    app_channels_note_latency(published);
+    update_actuators(trigger);
+}
+
+static K_WORK_DEFINE(eval_work, eval_work_handler);
+
+/* New measurements or setpoints: queue a re-evaluation on the system
+ * work queue. The listener runs in the publisher's thread, so it only
+ * records the trigger; the evaluation (actuator_lock, PID, actuator
+ * publish) never runs on the sensor loop's or Bluetooth's stack. */
+static void actuator_listener_cb(const struct zbus_channel *chan)
+{
+    uint32_t published, trigger;
+    k_spinlock_key_t key;
+
+    if (chan == &measurements_chan) {
+        const app_measurements_msg_t *msg = zbus_chan_const_msg(chan);
+
+        published = msg->cycles;
+        trigger = msg->trigger_cycles;
+    } else if (chan == &setpoints_chan) {
+        const app_setpoints_msg_t *msg = zbus_chan_const_msg(chan);
+
+        published = msg->cycles;
+        trigger = msg->trigger_cycles;
     } else {
-        gpio_pin_set_dt(&irrigation_gpio, 0);
+        return;
     }
+
+    key = k_spin_lock(&eval_lock);
+    if (!eval_pending) {
+        eval_publish_cycles = published;
+        eval_trigger_cycles = trigger;
+        eval_pending = true;
+    }
+    k_spin_unlock(&eval_lock, key);
+
+    k_work_submit(&eval_work);
 }
 
+ZBUS_LISTENER_DEFINE(actuator_listener, actuator_listener_cb);
+
 /* These remain unchanged from earlier (setpoints, validation, etc.) */
-void adjust_manager_apply_new_setpoints(const env_setpoints_t *new_sp)
+void adjust_manager_apply_new_setpoints(const env_setpoints_t *new_sp, uint32_t trigger_cycles)
 {
     if (!new_sp) return;
 
-    k_mutex_lock(&env.lock, K_FOREVER);
-    env.setpoints = *new_sp;
-    k_mutex_unlock(&env.lock);
+    env_controller_set_setpoints(new_sp, trigger_cycles);
 
     printk("Setpoints updated: T=%.1f  H=%.1f  L=%.1f\n",
            new_sp->target_temperature,
@@ -82,8 +985,51 @@ void adjust_manager_apply_new_setpoints(const env_setpoints_t *new_sp)
            new_sp->target_light);
 }
 
+/* Accepted setpoint ranges */
+#define SP_TEMP_MIN    0.0f
+#define SP_TEMP_MAX    50.0f
+#define SP_HUM_MIN     0.0f
+#define SP_HUM_MAX     100.0f
+#define SP_LUX_MIN     0.0f
+#define SP_LUX_MAX     65535.0f    /* BH1750 full scale */
+
 bool adjust_manager_validate(const env_setpoints_t *sp)
-{ … unchanged … }
+{
+    if (!sp) return false;
+
+    if (sp->target_temperature < SP_TEMP_MIN || sp->target_temperature > SP_TEMP_MAX)
+        return false;
+    if (sp->target_humidity < SP_HUM_MIN || sp->target_humidity > SP_HUM_MAX)
+        return false;
+    if (sp->target_light < SP_LUX_MIN || sp->target_light > SP_LUX_MAX)
+        return false;
+
+    return true;
+}
+
+int adjust_manager_process_action(env_mode_t requested_mode,
+                                   const env_setpoints_t *parsed_sp,
+                                   bool change_setpoints,
+                                   bool change_mode,
+                                   uint32_t trigger_cycles)
+{
+    if (change_mode) {
+        mode_controller_set_mode(requested_mode);
+    }
 
-void adjust_manager_process_action(...)
-{ … unchanged (for now until UART integration) … }
+    if (change_setpoints) {
+        /* Setpoints may only change while in ADJUSTING mode */
+        if (env_controller_get_mode() != ENV_MODE_ADJUSTING) {
+            printk("Setpoints rejected: system is READ_ONLY\n");
+            return -EPERM;
+        }
+
+        if (!adjust_manager_validate(parsed_sp)) {
+            printk("Setpoints rejected: out of range\n");
+            return -EINVAL;
+        }
+
+        adjust_manager_apply_new_setpoints(parsed_sp, trigger_cycles);
+    }
+    return 0;
+}
@@ -2,17 +2,135 @@
 #define ADJUST_MANAGER_H
 
 #include "env_controller.h"
+#include "actuator_output.h"
+#include "autotune.h"
 
-/* Applies validated setpoints to the global controller */
-void adjust_manager_apply_new_setpoints(const env_setpoints_t *new_sp);
+/* Configures actuator GPIOs (call once at boot). Returns the output
+ * layer's error if they are unavailable; actuation then stays off. */
+int adjust_manager_init(void);
+
+/* Drives actuators from the current measurements and setpoints, with a
+ * deadband and minimum on/off times per actuator. Runs on the system
+ * work queue whenever measurements or setpoints are published; only
+ * pins whose state changes are written. An actuator whose input channel
+ * is stale is held off, whatever controls it, until the channel
+ * recovers. */
+void adjust_manager_update_actuators(void);
+
+/* Target time from the sensor sample or command line behind a change
+ * to the GPIO transition */
+#define ADJUST_LATENCY_BUDGET_US  10000
+
+typedef struct {
+    uint32_t transitions;       /* Evaluations that changed a pin */
+    uint32_t avg_us;
+    uint32_t max_us;
+    uint32_t over_budget;       /* Transitions slower than the budget */
+} adjust_latency_t;
+
+void adjust_manager_get_latency(adjust_latency_t *out);
+
+/* Policy counters per actuator since boot (switches, on-time and duty
+ * are accounted by the actuator layer, see actuator_output_get_usage) */
+typedef struct {
+    uint32_t held;              /* Transitions delayed by a minimum on/off time */
+    uint32_t stale_off;         /* Times forced off because its input went stale */
+} adjust_counters_t;
+
+void adjust_manager_get_counters(actuator_id_t id, adjust_counters_t *out);
+
+/* Fan PID (PWM boards only; otherwise the fan stays on/off) */
+typedef struct {
+    bool available;             /* A fan-pwm output exists */
+    bool enabled;
+    float kp, ki, kd;           /* % duty per °C, per °C·s, per °C/s */
+    uint32_t duty_permille;
+} adjust_pid_info_t;
+
+/* -ENOTSUP when there is no PWM fan */
+int adjust_manager_set_pid_enabled(bool enable);
+void adjust_manager_set_pid_gains(float kp, float ki, float kd);
+void adjust_manager_get_pid(adjust_pid_info_t *out);
+
+/* Last temperature setpoint step: settling time into +-0.5 °C (held
+ * for a minute) and peak overshoot, for PID vs on/off comparison */
+typedef struct {
+    bool pid;                   /* Controller in use when the step started */
+    bool ff;                    /* Feed-forward was on */
+    bool settled;
+    uint32_t settle_ms;
+    int32_t overshoot_mc;       /* m°C past the setpoint */
+} adjust_step_response_t;
+
+/* 0, -EINPROGRESS while settling, -ENODATA before the first step */
+int adjust_manager_get_step_response(adjust_step_response_t *out);
+
+/* Irrigation mode: time-proportioned pulses (true, default) or on/off */
+void adjust_manager_set_irrigation_tp(bool enable);
+bool adjust_manager_get_irrigation_tp(void);
+
+/* Coordinated fan/pump control (default on): the pump yields to the
+ * ventilation unless the air is critically dry, and the fan waits for a
+ * wider temperature band while the air is dry. The on-time counters
+ * compare both modes over the time each was active. */
+typedef struct {
+    bool enabled;
+    uint32_t yield_s;           /* Pump demand held back for ventilation */
+    uint32_t defer_s;           /* Fan start deferred because the air was dry */
+    uint32_t run_s[2];          /* Time in [0] independent, [1] coordinated mode */
+    uint32_t on_s_per_h[2];     /* Fan + pump on-time per hour in each mode */
+} adjust_coord_info_t;
+
+void adjust_manager_set_coordinated(bool enable);
+void adjust_manager_get_coordination(adjust_coord_info_t *out);
+
+/* Feed-forward (default off): the fan and pump loops act on the
+ * temperature/humidity forecast horizon_s ahead instead of the reading.
+ * Time above the temperature target (+ fan deadband) and the largest
+ * excursion are kept per mode, [0] off and [1] on. */
+typedef struct {
+    bool enabled;
+    uint32_t horizon_s;
+    uint32_t run_s[2];
+    uint32_t over_s[2];
+    float over_max[2];          /* °C above target */
+} adjust_ff_info_t;
+
+void adjust_manager_set_feed_forward(bool enable);
+void adjust_manager_get_feed_forward(adjust_ff_info_t *out);
+
+/* Relay auto-tuning of the fan (temperature) or pump (humidity) gains
+ * around the current setpoint. The result replaces the gains and is
+ * saved with the settings subsystem, so later boots start tuned. */
+typedef struct {
+    autotune_state_t state;
+    actuator_id_t target;
+    int cycles;
+    float ku, pu_s;
+} adjust_autotune_info_t;
+
+/* -EINVAL for actuators without gains, -EBUSY while a run is active */
+int adjust_manager_autotune_start(actuator_id_t id);
+void adjust_manager_autotune_stop(void);
+void adjust_manager_get_autotune(adjust_autotune_info_t *out);
+
+/* Current gains of the fan or pump; returns true if they are stored */
+bool adjust_manager_get_gains(actuator_id_t id, float gains[3]);
+
+/* Applies validated setpoints to the global controller; 'trigger_cycles'
+ * is when the request arrived (k_cycle_get_32()) */
+void adjust_manager_apply_new_setpoints(const env_setpoints_t *new_sp, uint32_t trigger_cycles);
 
 /* Validates setpoints before applying them */
 bool adjust_manager_validate(const env_setpoints_t *sp);
 
-/* Converts parser results into system changes (WITHOUT UART) */
-void adjust_manager_process_action(env_mode_t requested_mode,
+/* Converts parser results into system changes (WITHOUT UART).
+ * Returns 0, -EPERM if setpoints were sent outside ADJUSTING mode or
+ * -EINVAL if they are out of range; a mode change is applied either way. */
+int adjust_manager_process_action(env_mode_t requested_mode,
                                    const env_setpoints_t *parsed_sp,
                                    bool change_setpoints,
-                                   bool change_mode);
+                                   bool change_mode,
+                                   uint32_t trigger_cycles);
 
 #endif /* ADJUST_MANAGER_H */
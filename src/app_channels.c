@@ -0,0 +1,83 @@
+/**
+ * @file app_channels.c
+ * @brief zbus channel definitions and latency bookkeeping
+ */
+
+#include <zephyr/kernel.h>
+#include "app_channels.h"
+
+/* Observers live in their modules */
+ZBUS_OBS_DECLARE(display_listener, actuator_listener, bt_listener);
+
+ZBUS_CHAN_DEFINE(measurements_chan, app_measurements_msg_t, NULL, NULL,
+                 ZBUS_OBSERVERS(display_listener, actuator_listener),
+                 ZBUS_MSG_INIT(0));
+
+ZBUS_CHAN_DEFINE(setpoints_chan, app_setpoints_msg_t, NULL, NULL,
+                 ZBUS_OBSERVERS(actuator_listener),
+                 ZBUS_MSG_INIT(.values = {25.0f, 60.0f, 500.0f}));
+
+ZBUS_CHAN_DEFINE(mode_chan, app_mode_msg_t, NULL, NULL,
+                 ZBUS_OBSERVERS(display_listener, bt_listener),
+                 ZBUS_MSG_INIT(.mode = ENV_MODE_READ_ONLY));
+
+ZBUS_CHAN_DEFINE(actuator_chan, app_actuator_msg_t, NULL, NULL,
+                 ZBUS_OBSERVERS(bt_listener),
+                 ZBUS_MSG_INIT(0));
+
+/* Latency accumulators: bus observers, and event handlers (button,
+ * Bluetooth lines). Noted from threads, listeners and the work queue. */
+typedef struct {
+    struct k_spinlock lock;
+    uint32_t count;
+    uint32_t max_us;
+    uint64_t sum_us;
+} latency_acc_t;
+
+static latency_acc_t bus_latency;
+static latency_acc_t event_latency;
+
+static void latency_note(latency_acc_t *acc, uint32_t since_cycles)
+{
+    uint32_t us = k_cyc_to_us_floor32(k_cycle_get_32() - since_cycles);
+    k_spinlock_key_t key = k_spin_lock(&acc->lock);
+
+    acc->count++;
+    acc->sum_us += us;
+    if (us > acc->max_us) {
+        acc->max_us = us;
+    }
+
+    k_spin_unlock(&acc->lock, key);
+}
+
+static void latency_get(latency_acc_t *acc, app_latency_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&acc->lock);
+
+    out->count = acc->count;
+    out->max_us = acc->max_us;
+    out->avg_us = acc->count ? (uint32_t)(acc->sum_us / acc->count) : 0;
+
+    k_spin_unlock(&acc->lock, key);
+}
+
+void app_channels_note_latency(uint32_t publish_cycles)
+{
+    latency_note(&bus_latency, publish_cycles);
+}
+
+void app_channels_get_latency(app_latency_t *out)
+{
+    latency_get(&bus_latency, out);
+}
+
+void app_channels_note_event_latency(uint32_t event_cycles)
+{
+    latency_note(&event_latency, event_cycles);
+}
+
+void app_channels_get_event_latency(app_latency_t *out)
+{
+    latency_get(&event_latency, out);
+}
@@ -0,0 +1,67 @@
+/**
+ * @file app_channels.h
+ * @brief zbus channels connecting sensors, controller, display and Bluetooth
+ *
+ * env_controller is the only publisher of measurements, setpoints and
+ * mode and publishes only when a value actually changes; adjust_manager
+ * publishes the actuator state. Every message carries the cycle counter
+ * at publish time so observers can report publish-to-consume latency.
+ */
+
+#ifndef APP_CHANNELS_H
+#define APP_CHANNELS_H
+
+#include <zephyr/zbus/zbus.h>
+#include "env_controller.h"
+#include "actuator_output.h"
+
+/* Actuator bits in app_actuator_msg_t.active */
+#define APP_ACTUATOR_FAN         BIT(ACTUATOR_FAN)
+#define APP_ACTUATOR_IRRIGATION  BIT(ACTUATOR_IRRIGATION)
+#define APP_ACTUATOR_LIGHT       BIT(ACTUATOR_LIGHT)
+
+typedef struct {
+    env_measurements_t values;
+    uint32_t cycles;            /* k_cycle_get_32() at publish */
+    uint32_t trigger_cycles;    /* ... when the sensors were sampled */
+} app_measurements_msg_t;
+
+typedef struct {
+    env_setpoints_t values;
+    uint32_t cycles;
+    uint32_t trigger_cycles;    /* ... when the command line arrived */
+} app_setpoints_msg_t;
+
+typedef struct {
+    env_mode_t mode;
+    uint32_t cycles;
+} app_mode_msg_t;
+
+typedef struct {
+    uint32_t active;            /* APP_ACTUATOR_* bits currently on */
+    uint32_t cycles;
+} app_actuator_msg_t;
+
+ZBUS_CHAN_DECLARE(measurements_chan, setpoints_chan, mode_chan, actuator_chan);
+
+/* Publish timeout used by all publishers */
+#define APP_CHAN_PUB_TIMEOUT  K_MSEC(50)
+
+/* Publish-to-consume latency, recorded by observers */
+typedef struct {
+    uint32_t count;
+    uint32_t max_us;
+    uint32_t avg_us;
+} app_latency_t;
+
+void app_channels_note_latency(uint32_t publish_cycles);
+void app_channels_get_latency(app_latency_t *out);
+
+/* Event-to-handler latency: a button press or a complete Bluetooth line
+ * until its handler runs, in either thread layout (the sensor cycle's
+ * release delay is the jitter in loop_timing.h). Kept apart from the
+ * bus figures above. */
+void app_channels_note_event_latency(uint32_t event_cycles);
+void app_channels_get_event_latency(app_latency_t *out);
+
+#endif /* APP_CHANNELS_H */
@@ -0,0 +1,109 @@
+/**
+ * @file autotune.c
+ * @brief Relay (Astrom-Hagglund) auto-tuning of PID gains
+ */
+
+#include <math.h>
+#include <zephyr/sys/util.h>
+#include "autotune.h"
+
+#define PI_F  3.14159265f
+
+void autotune_start(autotune_t *at, float setpoint, float hysteresis, bool reverse,
+                    float value, int64_t now_ms)
+{
+    float err = reverse ? value - setpoint : setpoint - value;
+
+    *at = (autotune_t){
+        .state = AUTOTUNE_RUNNING,
+        .setpoint = setpoint,
+        .hysteresis = hysteresis,
+        .reverse = reverse,
+        .output = err > 0.0f,
+        .start_ms = now_ms,
+        .last_on_ms = -1,
+        .hi = value,
+        .lo = value,
+    };
+}
+
+/* Ziegler-Nichols PID from the averaged oscillation */
+static void autotune_finish(autotune_t *at)
+{
+    int n = at->cycles - 1;
+    float a = at->amp_sum / n;
+
+    if (a <= at->hysteresis) {
+        /* Oscillation drowned in the hysteresis band: no usable Ku */
+        at->state = AUTOTUNE_FAILED;
+        return;
+    }
+
+    at->pu_s = at->period_sum_ms / n / 1000.0f;
+    at->ku = 4.0f * AUTOTUNE_RELAY_AMPLITUDE /
+             (PI_F * sqrtf(a * a - at->hysteresis * at->hysteresis));
+
+    at->gains[0] = 0.6f * at->ku;
+    at->gains[1] = 1.2f * at->ku / at->pu_s;
+    at->gains[2] = 0.075f * at->ku * at->pu_s;
+    at->state = AUTOTUNE_DONE;
+}
+
+bool autotune_step(autotune_t *at, float value, int64_t now_ms)
+{
+    if (at->state != AUTOTUNE_RUNNING) {
+        return false;
+    }
+
+    if (now_ms - at->start_ms > AUTOTUNE_TIMEOUT_MS) {
+        at->state = AUTOTUNE_FAILED;
+        return false;
+    }
+
+    at->hi = MAX(at->hi, value);
+    at->lo = MIN(at->lo, value);
+
+    /* Positive error: the output should be on */
+    float err = at->reverse ? value - at->setpoint : at->setpoint - value;
+
+    if (!at->output && err > at->hysteresis) {
+        at->output = true;
+
+        /* Switching on closes a full cycle */
+        if (at->last_on_ms >= 0) {
+            at->cycles++;
+            if (at->cycles > 1) {
+                at->amp_sum += (at->hi - at->lo) / 2.0f;
+                at->period_sum_ms += (float)(now_ms - at->last_on_ms);
+            }
+            if (at->cycles > AUTOTUNE_CYCLES) {
+                autotune_finish(at);
+                return false;
+            }
+        }
+        at->last_on_ms = now_ms;
+        at->hi = value;
+        at->lo = value;
+    } else if (at->output && err < -at->hysteresis) {
+        at->output = false;
+    }
+
+    return at->output;
+}
+
+void autotune_stop(autotune_t *at)
+{
+    if (at->state == AUTOTUNE_RUNNING) {
+        at->state = AUTOTUNE_IDLE;
+    }
+}
+
+const char *autotune_state_name(autotune_state_t state)
+{
+    switch (state) {
+    case AUTOTUNE_RUNNING: return "running";
+    case AUTOTUNE_DONE:    return "done";
+    case AUTOTUNE_FAILED:  return "failed";
+    default:               return "idle";
+    }
+}
@@ -0,0 +1,55 @@
+/**
+ * @file autotune.h
+ * @brief Relay (Astrom-Hagglund) auto-tuning of PID gains
+ *
+ * The actuator is driven fully on/off around the setpoint with a small
+ * hysteresis, which makes the process oscillate. After the first
+ * (transient) cycle the amplitude and period of AUTOTUNE_CYCLES cycles
+ * are averaged, giving the ultimate gain Ku = 4d / (pi * sqrt(a^2 - h^2))
+ * and period Pu, from which Ziegler-Nichols PID gains are computed.
+ */
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define AUTOTUNE_CYCLES           4
+#define AUTOTUNE_TIMEOUT_MS       (2 * 3600 * 1000)
+#define AUTOTUNE_RELAY_AMPLITUDE  50.0f     /* d: output swings 0..100 % */
+
+typedef enum {
+    AUTOTUNE_IDLE = 0,
+    AUTOTUNE_RUNNING,
+    AUTOTUNE_DONE,
+    AUTOTUNE_FAILED
+} autotune_state_t;
+
+typedef struct {
+    autotune_state_t state;
+    float setpoint;
+    float hysteresis;
+    bool reverse;           /* Output on when the value is above the setpoint */
+    bool output;
+    int64_t start_ms;
+    int64_t last_on_ms;     /* Start of the current cycle, -1 before the first */
+    float hi, lo;           /* Extremes within the current cycle */
+    int cycles;             /* Completed cycles, the first one not measured */
+    float amp_sum;
+    float period_sum_ms;
+    float ku, pu_s;         /* Result */
+    float gains[3];         /* kp, ki, kd in output % per unit, per unit*s, per unit/s */
+} autotune_t;
+
+void autotune_start(autotune_t *at, float setpoint, float hysteresis, bool reverse,
+                    float value, int64_t now_ms);
+
+/* Feeds one measurement; returns the relay output to apply */
+bool autotune_step(autotune_t *at, float value, int64_t now_ms);
+
+void autotune_stop(autotune_t *at);
+
+const char *autotune_state_name(autotune_state_t state);
+
+#endif /* AUTOTUNE_H */
@@ -16,10 +16,158 @@ static bool str_iequals(const char *a, const char *b)
     return (*a == '\0' && *b == '\0');
 }
 
+/* Helper: case-insensitive prefix check */
+static bool str_istarts_with(const char *s, const char *prefix)
+{
+    while (*prefix) {
+        if (tolower((unsigned char)*s) != tolower((unsigned char)*prefix))
+            return false;
+        s++; prefix++;
+    }
+    return true;
+}
+
+/* Maps a channel key (TEMP/HUM/LUX) to its sensor channel */
+static bool parse_channel(const char *key, sensor_ch_t *ch)
+{
+    for (int i = 0; i < SENSOR_CH_COUNT; i++) {
+        if (str_iequals(key, sensor_channel_name((sensor_ch_t)i))) {
+            *ch = (sensor_ch_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Parses "STATS=<channel>[,<window>]", window being 1M (this minute),
+ * 1H/24H/7D (rolling) */
+static bool parse_stats_query(char *args, parser_result_t *result)
+{
+    char *comma = strchr(args, ',');
+
+    result->window = STATS_WIN_HOUR;
+    if (comma) {
+        *comma = '\0';
+        bool found = false;
+        for (int w = 0; w < STATS_WIN_COUNT; w++) {
+            if (str_iequals(comma + 1, stats_window_name((stats_window_t)w))) {
+                result->window = (stats_window_t)w;
+                found = true;
+            }
+        }
+        if (!found) return false;
+    }
+
+    return parse_channel(args, &result->channel);
+}
+
+/* Parses "<channel>,<value>[,Y]" for percentile/threshold queries */
+static bool parse_sketch_query(char *args, parser_result_t *result)
+{
+    char *value = strchr(args, ',');
+    if (!value) return false;
+    *value++ = '\0';
+
+    char *day = strchr(value, ',');
+    result->day = QUANTILE_DAY_TODAY;
+    if (day) {
+        *day++ = '\0';
+        if (!str_iequals(day, "Y")) return false;
+        result->day = QUANTILE_DAY_YESTERDAY;
+    }
+
+    result->query_value = atof(value);
+    return parse_channel(args, &result->channel);
+}
+
+/* Parses "<kp>,<ki>,<kd>" (all non-negative) */
+static bool parse_pid_gains(char *args, parser_result_t *result)
+{
+    char *next = args;
+
+    for (int i = 0; i < 3; i++) {
+        char *comma = strchr(next, ',');
+
+        if ((i < 2) != (comma != NULL)) return false;
+        if (comma) *comma = '\0';
+
+        char *end;
+        result->gains[i] = strtof(next, &end);
+        if (end == next || *end != '\0' || result->gains[i] < 0.0f) return false;
+
+        next = comma ? comma + 1 : NULL;
+    }
+    return true;
+}
+
+/* Parses "HH:MM" into a minute of the day */
+static bool parse_clock(const char *s, uint16_t *minute)
+{
+    char *end;
+    long h = strtol(s, &end, 10);
+
+    if (end == s || *end != ':') return false;
+
+    const char *m_str = end + 1;
+    long m = strtol(m_str, &end, 10);
+
+    if (end == m_str || *end != '\0') return false;
+    if (h < 0 || h > 23 || m < 0 || m > 59) return false;
+
+    *minute = (uint16_t)(h * 60 + m);
+    return true;
+}
+
+/* Parses "HH:MM,<temp>,<hum>,<lux>" for a schedule entry */
+static bool parse_schedule_entry(char *args, parser_result_t *result)
+{
+    float *targets[3] = {
+        &result->new_setpoints.target_temperature,
+        &result->new_setpoints.target_humidity,
+        &result->new_setpoints.target_light,
+    };
+    char *next = strchr(args, ',');
+
+    if (!next) return false;
+    *next++ = '\0';
+    if (!parse_clock(args, &result->minute)) return false;
+
+    for (int i = 0; i < 3; i++) {
+        char *comma = strchr(next, ',');
+
+        if ((i < 2) != (comma != NULL)) return false;
+        if (comma) *comma = '\0';
+
+        char *end;
+        *targets[i] = strtof(next, &end);
+        if (end == next || *end != '\0') return false;
+
+        next = comma ? comma + 1 : NULL;
+    }
+    return true;
+}
+
 /* Parses commands like:
  *  TEMP=25.5,HUM=60,LUX=500
  *  MODE=READ
  *  MODE=ADJUST
+ *  STATS=TEMP,1H
+ *  PCT=HUM,95      (PCT=HUM,95,Y for yesterday)
+ *  BELOW=HUM,60
+ *  HEALTH
+ *  TIMING
+ *  USAGE
+ *  TREND           (FF=ON, FF=OFF)
+ *  PID             (PID=ON, PID=OFF, PID=<kp>,<ki>,<kd>)
+ *  TUNE            (TUNE=FAN, TUNE=PUMP, TUNE=STOP)
+ *  IRR             (IRR=TP, IRR=ONOFF)
+ *  COORD           (COORD=ON, COORD=OFF)
+ *  SCHED           (SCHED=ON, SCHED=OFF, SCHED=CLR)
+ *  SCHED+=06:00,24,65,400
+ *  CLOCK=14:30
+ *  RULES           (RULE=CLR, RULE-=<n>)
+ *  RULE+=IF TEMP>30 AND HUM<40 THEN PUMP ON FOR 5M
+ *  TRACE           (TRACE=ON, TRACE=OFF, TRACE=CLR, TRACE=DUMP)
  */
 parser_result_t command_parser_parse(const char *cmd,
                                      const env_setpoints_t *current_sp)
@@ -37,6 +185,13 @@ parser_result_t command_parser_parse(const char *cmd,
     strncpy(buffer, cmd, sizeof(buffer) - 1);
     buffer[sizeof(buffer) - 1] = '\0';
 
+    /* Rules keep their spaces, so they are taken before the stripping */
+    if (str_istarts_with(buffer, "RULE+=")) {
+        strncpy(result.text, buffer + 6, sizeof(result.text) - 1);
+        result.action = PARSER_ACTION_RULE_ADD;
+        return result;
+    }
+
     /* Remove spaces */
     for (int i = 0; buffer[i]; i++)
         if (buffer[i] == ' ') buffer[i] = '\0';
@@ -51,6 +206,172 @@ parser_result_t command_parser_parse(const char *cmd,
         return result;
     }
 
+    if (str_iequals(buffer, "HEALTH")) {
+        result.action = PARSER_ACTION_QUERY_HEALTH;
+        return result;
+    }
+
+    if (str_iequals(buffer, "TIMING")) {
+        result.action = PARSER_ACTION_QUERY_TIMING;
+        return result;
+    }
+
+    if (str_iequals(buffer, "USAGE")) {
+        result.action = PARSER_ACTION_QUERY_USAGE;
+        return result;
+    }
+
+    if (str_iequals(buffer, "TREND")) {
+        result.action = PARSER_ACTION_QUERY_TREND;
+        return result;
+    }
+    if (str_iequals(buffer, "FF=ON") || str_iequals(buffer, "FF=OFF")) {
+        result.action = PARSER_ACTION_SET_FEED_FORWARD;
+        result.enable = str_iequals(buffer, "FF=ON");
+        return result;
+    }
+
+    /* ---- Fan PID ---- */
+    if (str_iequals(buffer, "PID")) {
+        result.action = PARSER_ACTION_QUERY_PID;
+        return result;
+    }
+    if (str_iequals(buffer, "PID=ON") || str_iequals(buffer, "PID=OFF")) {
+        result.action = PARSER_ACTION_SET_PID_ENABLE;
+        result.enable = str_iequals(buffer, "PID=ON");
+        return result;
+    }
+    if (str_istarts_with(buffer, "PID=")) {
+        if (parse_pid_gains(buffer + 4, &result)) {
+            result.action = PARSER_ACTION_SET_PID_GAINS;
+        }
+        return result;
+    }
+
+    /* ---- Relay auto-tuning ---- */
+    if (str_iequals(buffer, "TUNE")) {
+        result.action = PARSER_ACTION_QUERY_TUNE;
+        return result;
+    }
+    if (str_iequals(buffer, "TUNE=STOP")) {
+        result.action = PARSER_ACTION_STOP_TUNE;
+        return result;
+    }
+    if (str_iequals(buffer, "TUNE=FAN") || str_iequals(buffer, "TUNE=PUMP")) {
+        result.action = PARSER_ACTION_START_TUNE;
+        result.actuator = str_iequals(buffer, "TUNE=FAN") ? ACTUATOR_FAN : ACTUATOR_IRRIGATION;
+        return result;
+    }
+
+    /* ---- Irrigation mode ---- */
+    if (str_iequals(buffer, "IRR")) {
+        result.action = PARSER_ACTION_QUERY_IRRIGATION;
+        return result;
+    }
+    if (str_iequals(buffer, "IRR=TP") || str_iequals(buffer, "IRR=ONOFF")) {
+        result.action = PARSER_ACTION_SET_IRRIGATION_MODE;
+        result.enable = str_iequals(buffer, "IRR=TP");
+        return result;
+    }
+
+    /* ---- Fan/pump coordination ---- */
+    if (str_iequals(buffer, "COORD")) {
+        result.action = PARSER_ACTION_QUERY_COORD;
+        return result;
+    }
+    if (str_iequals(buffer, "COORD=ON") || str_iequals(buffer, "COORD=OFF")) {
+        result.action = PARSER_ACTION_SET_COORD;
+        result.enable = str_iequals(buffer, "COORD=ON");
+        return result;
+    }
+
+    /* ---- Setpoint schedule ---- */
+    if (str_iequals(buffer, "SCHED")) {
+        result.action = PARSER_ACTION_QUERY_SCHEDULE;
+        return result;
+    }
+    if (str_iequals(buffer, "SCHED=ON") || str_iequals(buffer, "SCHED=OFF")) {
+        result.action = PARSER_ACTION_SCHEDULE_ENABLE;
+        result.enable = str_iequals(buffer, "SCHED=ON");
+        return result;
+    }
+    if (str_iequals(buffer, "SCHED=CLR")) {
+        result.action = PARSER_ACTION_SCHEDULE_CLEAR;
+        return result;
+    }
+    if (str_istarts_with(buffer, "SCHED+=")) {
+        if (parse_schedule_entry(buffer + 7, &result)) {
+            result.action = PARSER_ACTION_SCHEDULE_ADD;
+        }
+        return result;
+    }
+    if (str_istarts_with(buffer, "CLOCK=")) {
+        if (parse_clock(buffer + 6, &result.minute)) {
+            result.action = PARSER_ACTION_SET_CLOCK;
+        }
+        return result;
+    }
+
+    /* ---- Automation rules ---- */
+    if (str_iequals(buffer, "RULES")) {
+        result.action = PARSER_ACTION_QUERY_RULES;
+        return result;
+    }
+    if (str_iequals(buffer, "RULE=CLR")) {
+        result.action = PARSER_ACTION_RULE_CLEAR;
+        return result;
+    }
+    if (str_istarts_with(buffer, "RULE-=")) {
+        char *end;
+        result.index = (int)strtol(buffer + 6, &end, 10);
+        if (end != buffer + 6 && *end == '\0') {
+            result.action = PARSER_ACTION_RULE_REMOVE;
+        }
+        return result;
+    }
+
+    /* ---- Sample/command trace ---- */
+    if (str_iequals(buffer, "TRACE")) {
+        result.action = PARSER_ACTION_QUERY_TRACE;
+        return result;
+    }
+    if (str_iequals(buffer, "TRACE=ON") || str_iequals(buffer, "TRACE=OFF")) {
+        result.action = PARSER_ACTION_SET_TRACE;
+        result.enable = str_iequals(buffer, "TRACE=ON");
+        return result;
+    }
+    if (str_iequals(buffer, "TRACE=CLR")) {
+        result.action = PARSER_ACTION_TRACE_CLEAR;
+        return result;
+    }
+    if (str_iequals(buffer, "TRACE=DUMP")) {
+        result.action = PARSER_ACTION_TRACE_DUMP;
+        return result;
+    }
+
+    /* ---- Parse aggregate queries ---- */
+    if (str_istarts_with(buffer, "STATS=")) {
+        if (parse_stats_query(buffer + 6, &result)) {
+            result.action = PARSER_ACTION_QUERY_STATS;
+        }
+        return result;
+    }
+
+    if (str_istarts_with(buffer, "PCT=")) {
+        if (parse_sketch_query(buffer + 4, &result) &&
+            result.query_value >= 0.0f && result.query_value <= 100.0f) {
+            result.action = PARSER_ACTION_QUERY_PERCENTILE;
+        }
+        return result;
+    }
+
+    if (str_istarts_with(buffer, "BELOW=")) {
+        if (parse_sketch_query(buffer + 6, &result)) {
+            result.action = PARSER_ACTION_QUERY_BELOW;
+        }
+        return result;
+    }
+
     /* ---- Parse setpoint commands ---- */
     /* Expected format: TEMP=xx,HUM=xx,LUX=xx */
     char *token = strtok(buffer, ",");
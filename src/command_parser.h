@@ -2,19 +2,64 @@
 #define COMMAND_PARSER_H
 
 #include "env_controller.h"
+#include "stats_rollup.h"
+#include "quantile_sketch.h"
+#include "actuator_output.h"
 
 /* Actions the parser can request */
 typedef enum {
     PARSER_ACTION_NONE = 0,
     PARSER_ACTION_SET_SETPOINTS,
     PARSER_ACTION_MODE_READ,
-    PARSER_ACTION_MODE_ADJUST
+    PARSER_ACTION_MODE_ADJUST,
+    PARSER_ACTION_QUERY_STATS,
+    PARSER_ACTION_QUERY_PERCENTILE,
+    PARSER_ACTION_QUERY_BELOW,
+    PARSER_ACTION_QUERY_HEALTH,
+    PARSER_ACTION_QUERY_TIMING,
+    PARSER_ACTION_QUERY_USAGE,
+    PARSER_ACTION_QUERY_TREND,
+    PARSER_ACTION_SET_FEED_FORWARD,
+    PARSER_ACTION_QUERY_PID,
+    PARSER_ACTION_SET_PID_ENABLE,
+    PARSER_ACTION_SET_PID_GAINS,
+    PARSER_ACTION_QUERY_TUNE,
+    PARSER_ACTION_START_TUNE,
+    PARSER_ACTION_STOP_TUNE,
+    PARSER_ACTION_QUERY_IRRIGATION,
+    PARSER_ACTION_SET_IRRIGATION_MODE,
+    PARSER_ACTION_QUERY_COORD,
+    PARSER_ACTION_SET_COORD,
+    PARSER_ACTION_QUERY_SCHEDULE,
+    PARSER_ACTION_SCHEDULE_ADD,
+    PARSER_ACTION_SCHEDULE_CLEAR,
+    PARSER_ACTION_SCHEDULE_ENABLE,
+    PARSER_ACTION_SET_CLOCK,
+    PARSER_ACTION_QUERY_RULES,
+    PARSER_ACTION_RULE_ADD,
+    PARSER_ACTION_RULE_REMOVE,
+    PARSER_ACTION_RULE_CLEAR,
+    PARSER_ACTION_QUERY_TRACE,
+    PARSER_ACTION_SET_TRACE,
+    PARSER_ACTION_TRACE_CLEAR,
+    PARSER_ACTION_TRACE_DUMP
 } parser_action_t;
 
 /* Resulting structure after parsing a command */
 typedef struct {
     parser_action_t action;
-    env_setpoints_t new_setpoints; /* Only valid when action == SET_SETPOINTS */
+    env_setpoints_t new_setpoints; /* SET_SETPOINTS, SCHEDULE_ADD */
+    sensor_ch_t channel;           /* Only valid for QUERY_* actions */
+    stats_window_t window;         /* Only valid when action == QUERY_STATS */
+    float query_value;             /* Percentile or threshold for PERCENTILE/BELOW */
+    quantile_day_t day;            /* Day for PERCENTILE/BELOW */
+    bool enable;                   /* SET_PID_ENABLE, SET_COORD, SCHEDULE_ENABLE, SET_FEED_FORWARD,
+                                    * SET_TRACE, SET_IRRIGATION_MODE (true = TP) */
+    float gains[3];                /* SET_PID_GAINS: kp, ki, kd */
+    actuator_id_t actuator;        /* START_TUNE */
+    uint16_t minute;               /* SCHEDULE_ADD, SET_CLOCK: minute of the day */
+    int index;                     /* RULE_REMOVE */
+    char text[64];                 /* RULE_ADD: rule source, spaces kept */
 } parser_result_t;
 
 /* Parses a Bluetooth command string */
@@ -6,10 +6,14 @@
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
+#include <math.h>
 #include <zephyr/kernel.h>
 #include "SPI_LCD/spi_lcd_nokia.h"
 #include "SPI_LCD/lcd_nokia_images.h"
 #include "display_manager.h"
+#include "app_channels.h"
+#include "actuator_output.h"
+#include "trend.h"
 
 /* Macro to avoid float to double promotion warning */
 #define FLOAT_TO_DBL(f) ((double)(f))
@@ -17,6 +21,38 @@
 /* Private variables */
 static bool display_initialized = false;
 
+/* Live page data, kept current by the zbus listener */
+static struct k_spinlock live_lock;
+static display_data_t live_data = { .mode = MODE_READ_ONLY };
+static bool live_dirty = true;
+static struct k_poll_signal live_signal = K_POLL_SIGNAL_INITIALIZER(live_signal);
+
+/* Runs in the publisher's context: only caches the values */
+static void display_listener_cb(const struct zbus_channel *chan)
+{
+    k_spinlock_key_t key = k_spin_lock(&live_lock);
+
+    if (chan == &measurements_chan) {
+        const app_measurements_msg_t *msg = zbus_chan_const_msg(chan);
+
+        live_data.temperature = msg->values.temperature;
+        live_data.light_level = msg->values.light;
+        live_data.humidity = msg->values.humidity;
+        app_channels_note_latency(msg->cycles);
+    } else if (chan == &mode_chan) {
+        const app_mode_msg_t *msg = zbus_chan_const_msg(chan);
+
+        live_data.mode = (msg->mode == ENV_MODE_ADJUSTING) ? MODE_ADJUSTING : MODE_READ_ONLY;
+        app_channels_note_latency(msg->cycles);
+    }
+    live_dirty = true;
+
+    k_spin_unlock(&live_lock, key);
+    k_poll_signal_raise(&live_signal, 0);
+}
+
+ZBUS_LISTENER_DEFINE(display_listener, display_listener_cb);
+
 int display_init(void)
 {
     int ret;
@@ -67,13 +103,16 @@ void display_update(const display_data_t *data)
     */
     
     /* Format and display strings */
-    snprintf(temp_str, sizeof(temp_str), "Temp: %.1fC", (double)data->temperature);
+    snprintf(temp_str, sizeof(temp_str), "Temp: %.1fC %c", (double)data->temperature,
+             data->temp_trend ? data->temp_trend : ' ');
     LCD_nokia_write_string_xy_FB(0, 0, (uint8_t *)temp_str);
     
-    snprintf(light_str, sizeof(light_str), "Light: %.0f lux", (double)data->light_level);
+    snprintf(light_str, sizeof(light_str), "Light: %.0flx %c", (double)data->light_level,
+             data->light_trend ? data->light_trend : ' ');
     LCD_nokia_write_string_xy_FB(0, 1, (uint8_t *)light_str);
     
-    snprintf(humid_str, sizeof(humid_str), "Humid: %.1f%%", (double)data->humidity);
+    snprintf(humid_str, sizeof(humid_str), "Humid: %.1f%% %c", (double)data->humidity,
+             data->humid_trend ? data->humid_trend : ' ');
     LCD_nokia_write_string_xy_FB(0, 2, (uint8_t *)humid_str);
     
     snprintf(mode_str, sizeof(mode_str), "Mode: %s", 
@@ -83,6 +122,100 @@ void display_update(const display_data_t *data)
     LCD_nokia_sent_FrameBuffer();
 }
 
+bool display_refresh(bool force)
+{
+    display_data_t data;
+    bool dirty;
+
+    k_spinlock_key_t key = k_spin_lock(&live_lock);
+    data = live_data;
+    dirty = live_dirty;
+    live_dirty = false;
+    k_spin_unlock(&live_lock, key);
+    k_poll_signal_reset(&live_signal);
+
+    if (!dirty && !force) {
+        return false;
+    }
+
+    data.temp_trend = trend_arrow(SENSOR_CH_TEMPERATURE);
+    data.light_trend = trend_arrow(SENSOR_CH_LIGHT);
+    data.humid_trend = trend_arrow(SENSOR_CH_HUMIDITY);
+    display_update(&data);
+    return true;
+}
+
+void display_init_poll_event(struct k_poll_event *event)
+{
+    k_poll_event_init(event, K_POLL_TYPE_SIGNAL, K_POLL_MODE_NOTIFY_ONLY, &live_signal);
+}
+
+void display_show_stats(sensor_ch_t ch, stats_window_t win)
+{
+    stats_summary_t sum;
+    char line[20];
+
+    if (!display_initialized) {
+        return;
+    }
+
+    LCD_nokia_clear();
+
+    snprintf(line, sizeof(line), "%s %s", sensor_channel_name(ch), stats_window_name(win));
+    LCD_nokia_write_string_xy_FB(0, 0, (uint8_t *)line);
+
+    if (stats_rollup_get(ch, win, &sum) != 0) {
+        LCD_nokia_write_string_xy_FB(0, 2, (uint8_t *)"No data");
+        LCD_nokia_sent_FrameBuffer();
+        return;
+    }
+
+    snprintf(line, sizeof(line), "Min: %.1f", FLOAT_TO_DBL(sum.min));
+    LCD_nokia_write_string_xy_FB(0, 1, (uint8_t *)line);
+
+    snprintf(line, sizeof(line), "Max: %.1f", FLOAT_TO_DBL(sum.max));
+    LCD_nokia_write_string_xy_FB(0, 2, (uint8_t *)line);
+
+    snprintf(line, sizeof(line), "Avg: %.1f", FLOAT_TO_DBL(sum.mean));
+    LCD_nokia_write_string_xy_FB(0, 3, (uint8_t *)line);
+
+    snprintf(line, sizeof(line), "SD:  %.2f", FLOAT_TO_DBL(sqrtf(sum.variance)));
+    LCD_nokia_write_string_xy_FB(0, 4, (uint8_t *)line);
+
+    snprintf(line, sizeof(line), "n=%u", (unsigned int)sum.count);
+    LCD_nokia_write_string_xy_FB(0, 5, (uint8_t *)line);
+
+    LCD_nokia_sent_FrameBuffer();
+}
+
+void display_show_usage(void)
+{
+    char line[20];
+    float total_wh = 0.0f;
+
+    if (!display_initialized) {
+        return;
+    }
+
+    LCD_nokia_clear();
+    LCD_nokia_write_string_xy_FB(0, 0, (uint8_t *)"Duty  1h  24h");
+
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        actuator_usage_t u;
+
+        actuator_output_get_usage((actuator_id_t)i, &u);
+        snprintf(line, sizeof(line), "%-5s%3u%% %3u%%", actuator_name((actuator_id_t)i),
+                 (unsigned int)((u.duty_1h_permille + 5) / 10),
+                 (unsigned int)((u.duty_24h_permille + 5) / 10));
+        LCD_nokia_write_string_xy_FB(0, 1 + i, (uint8_t *)line);
+        total_wh += u.energy_wh;
+    }
+
+    snprintf(line, sizeof(line), "E: %.0f Wh", FLOAT_TO_DBL(total_wh));
+    LCD_nokia_write_string_xy_FB(0, 5, (uint8_t *)line);
+
+    LCD_nokia_sent_FrameBuffer();
+}
 
 void display_clear(void)
 {
@@ -7,6 +7,8 @@
 #define DISPLAY_MANAGER_H
 
 #include <stdbool.h>
+#include <zephyr/kernel.h>
+#include "stats_rollup.h"
 
 /* System mode enumeration */
 typedef enum {
@@ -20,6 +22,9 @@ typedef struct {
     float light_level;   /* Light level in lux */
     float humidity;      /* Humidity percentage */
     system_mode_t mode;  /* Current system mode */
+    char temp_trend;     /* Trend arrows ('^', 'v', '-', '?'); 0 hides them */
+    char light_trend;
+    char humid_trend;
 } display_data_t;
 
 /* Display initialization and control */
@@ -35,6 +40,19 @@ void display_show_iteso_logo(void);
 void display_update(const display_data_t *data);
 void display_update_table_format(const display_data_t *data);
 
+/* Redraws the live page from the latest published data, only if it
+ * changed since the last draw (or force); returns true if redrawn */
+bool display_refresh(bool force);
+
+/* Poll event raised when new live data is waiting to be drawn */
+void display_init_poll_event(struct k_poll_event *event);
+
+/* Aggregate page: min/max/mean/sd of one channel over a window */
+void display_show_stats(sensor_ch_t ch, stats_window_t win);
+
+/* Usage page: rolling 1 h / 24 h duty per actuator and total energy */
+void display_show_usage(void);
+
 /* Special display modes */
 void display_setpoints(float temp_setpoint, float light_setpoint, float humid_setpoint);
 void display_draw_graph(const float *values, uint8_t count, float max_value, uint8_t row);
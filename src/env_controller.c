@@ -1,7 +1,12 @@
+#include <zephyr/sys/atomic.h>
+#include <zephyr/sys/barrier.h>
+#include <string.h>
+
 #include "env_controller.h"
+#include "app_channels.h"
 
-/* Global environment controller instance */
-env_controller_t env = {
+/* Published state, only touched between sequence increments */
+static env_state_t state = {
     .mode = ENV_MODE_READ_ONLY,
     .measurements = {0.0f, 0.0f, 0.0f},
     .setpoints = {
@@ -11,10 +16,214 @@ env_controller_t env = {
     }
 };
 
+/* Odd while a write is in progress; generation = seq / 2 */
+static atomic_t seq = ATOMIC_INIT(0);
+
+/*
+ * Single writer: the mode button, Bluetooth and the sensor loop do not
+ * touch 'state' themselves, they hand a request to the env_writer
+ * thread and wait for it. The writer is cooperative, so no other thread
+ * runs while seq is odd and a reader on the same core never retries.
+ */
+typedef enum {
+    ENV_WRITE_MODE,
+    ENV_WRITE_TOGGLE_MODE,
+    ENV_WRITE_SETPOINTS,
+    ENV_WRITE_MEASUREMENTS
+} env_write_op_t;
+
+typedef struct {
+    env_write_op_t op;
+    union {
+        env_mode_t mode;
+        env_setpoints_t setpoints;
+        env_measurements_t measurements;
+    } value;
+    bool changed;               /* Set by the writer */
+    struct k_sem done;
+} env_write_req_t;
+
+#define ENV_WRITER_STACK_SIZE   512
+#define ENV_WRITER_PRIORITY     K_PRIO_COOP(2)
+
+/* Requests live on the caller's stack until 'done' is given */
+K_MSGQ_DEFINE(write_q, sizeof(env_write_req_t *), 4, sizeof(env_write_req_t *));
+
+/* Only the writer updates these; readers take them as they come */
+static uint32_t stat_writes;
+static atomic_t stat_retries;
+
 void env_controller_init(void)
 {
-    /* Initialize the mutex that protects global state */
-    k_mutex_init(&env.lock);
-
     /* Optionally overwrite default values here if needed */
 }
+
+static void apply_write(env_write_req_t *req)
+{
+    switch (req->op) {
+    case ENV_WRITE_MODE:
+        req->changed = (state.mode != req->value.mode);
+        state.mode = req->value.mode;
+        break;
+    case ENV_WRITE_TOGGLE_MODE:
+        state.mode = (state.mode == ENV_MODE_READ_ONLY) ? ENV_MODE_ADJUSTING : ENV_MODE_READ_ONLY;
+        req->value.mode = state.mode;
+        req->changed = true;
+        break;
+    case ENV_WRITE_SETPOINTS:
+        req->changed = (memcmp(&state.setpoints, &req->value.setpoints,
+                               sizeof(state.setpoints)) != 0);
+        state.setpoints = req->value.setpoints;
+        break;
+    case ENV_WRITE_MEASUREMENTS:
+        req->changed = (memcmp(&state.measurements, &req->value.measurements,
+                               sizeof(state.measurements)) != 0);
+        state.measurements = req->value.measurements;
+        break;
+    }
+}
+
+/* Owner of 'state': the only code that moves seq */
+static void env_writer_thread(void *p1, void *p2, void *p3)
+{
+    env_write_req_t *req;
+
+    for (;;) {
+        k_msgq_get(&write_q, &req, K_FOREVER);
+
+        /* Readers that start now will retry until seq is even again */
+        atomic_inc(&seq);
+        barrier_dmem_fence_full();
+        apply_write(req);
+        barrier_dmem_fence_full();
+        atomic_inc(&seq);
+        stat_writes++;
+
+        k_sem_give(&req->done);
+    }
+}
+
+K_THREAD_DEFINE(env_writer_tid, ENV_WRITER_STACK_SIZE, env_writer_thread,
+                NULL, NULL, NULL, ENV_WRITER_PRIORITY, 0, 0);
+
+/* Hands a request to the writer and waits until it is applied */
+static void submit_write(env_write_req_t *req)
+{
+    k_sem_init(&req->done, 0, 1);
+    k_msgq_put(&write_q, &req, K_FOREVER);
+    k_sem_take(&req->done, K_FOREVER);
+}
+
+uint32_t env_controller_read(env_state_t *out)
+{
+    atomic_val_t start;
+
+    for (;;) {
+        start = atomic_get(&seq);
+        if ((start & 1) == 0) {
+            barrier_dmem_fence_full();
+            *out = state;
+            barrier_dmem_fence_full();
+            if (atomic_get(&seq) == start) {
+                break;
+            }
+        }
+        /* Overlapped the writer on another core: it cannot be
+         * preempted, so the window closes within one struct copy */
+        atomic_inc(&stat_retries);
+    }
+
+    return (uint32_t)start >> 1;
+}
+
+uint32_t env_controller_generation(void)
+{
+    return (uint32_t)atomic_get(&seq) >> 1;
+}
+
+env_mode_t env_controller_get_mode(void)
+{
+    env_state_t s;
+
+    env_controller_read(&s);
+    return s.mode;
+}
+
+void env_controller_get_setpoints(env_setpoints_t *out)
+{
+    env_state_t s;
+
+    env_controller_read(&s);
+    *out = s.setpoints;
+}
+
+void env_controller_get_measurements(env_measurements_t *out)
+{
+    env_state_t s;
+
+    env_controller_read(&s);
+    *out = s.measurements;
+}
+
+/* Change notifications, published after the write completes */
+static void publish_mode(env_mode_t mode)
+{
+    app_mode_msg_t msg = { .mode = mode, .cycles = k_cycle_get_32() };
+
+    zbus_chan_pub(&mode_chan, &msg, APP_CHAN_PUB_TIMEOUT);
+}
+
+void env_controller_set_mode(env_mode_t mode)
+{
+    env_write_req_t req = { .op = ENV_WRITE_MODE, .value.mode = mode };
+
+    submit_write(&req);
+
+    if (req.changed) {
+        publish_mode(mode);
+    }
+}
+
+env_mode_t env_controller_toggle_mode(void)
+{
+    env_write_req_t req = { .op = ENV_WRITE_TOGGLE_MODE };
+
+    submit_write(&req);
+
+    publish_mode(req.value.mode);
+    return req.value.mode;
+}
+
+void env_controller_set_setpoints(const env_setpoints_t *sp, uint32_t trigger_cycles)
+{
+    env_write_req_t req = { .op = ENV_WRITE_SETPOINTS, .value.setpoints = *sp };
+
+    submit_write(&req);
+
+    if (req.changed) {
+        app_setpoints_msg_t msg = {
+            .values = *sp, .cycles = k_cycle_get_32(), .trigger_cycles = trigger_cycles
+        };
+        zbus_chan_pub(&setpoints_chan, &msg, APP_CHAN_PUB_TIMEOUT);
+    }
+}
+
+void env_controller_set_measurements(const env_measurements_t *m, uint32_t trigger_cycles)
+{
+    env_write_req_t req = { .op = ENV_WRITE_MEASUREMENTS, .value.measurements = *m };
+
+    submit_write(&req);
+
+    if (req.changed) {
+        app_measurements_msg_t msg = {
+            .values = *m, .cycles = k_cycle_get_32(), .trigger_cycles = trigger_cycles
+        };
+        zbus_chan_pub(&measurements_chan, &msg, APP_CHAN_PUB_TIMEOUT);
+    }
+}
+
+void env_controller_get_stats(env_controller_stats_t *out)
+{
+    out->writes = stat_writes;
+    out->read_retries = (uint32_t)atomic_get(&stat_retries);
+}
@@ -14,6 +14,8 @@ typedef struct {
     float temperature;   /* Celsius */
     float humidity;      /* Percentage */
     float light;         /* Lux */
+    uint32_t stale;      /* BIT(sensor_ch_t) of channels without a recent
+                          * valid sample; their value is the last one */
 } env_measurements_t;
 
 /* User-defined target values (adjustable by Bluetooth or UI) */
@@ -23,18 +25,53 @@ typedef struct {
     float target_light;         /* Lux */
 } env_setpoints_t;
 
-/* Central environment controller structure */
+/* Snapshot of the shared controller state */
 typedef struct {
     env_mode_t mode;
     env_measurements_t measurements;
     env_setpoints_t setpoints;
-    struct k_mutex lock; /* Protects all shared data */
-} env_controller_t;
+} env_state_t;
 
-/* Global instance */
-extern env_controller_t env;
+/* Seqlock counters, for diagnostics */
+typedef struct {
+    uint32_t writes;
+    uint32_t read_retries;      /* Read attempts that overlapped a write (SMP only) */
+} env_controller_stats_t;
+
+/*
+ * The state is published as a seqlock with a single writer: the setters
+ * below pass their update to a cooperative writer thread, which bumps a
+ * sequence counter before and after applying it, and block until it is
+ * done. Readers copy the snapshot without locking or any read-modify-
+ * write and retry only if the counter moved, which takes a writer on
+ * another core. Reads never block; call them from threads, not ISRs.
+ * The setters block and must not be called from ISRs either.
+ */
 
-/* Initializes the controller (mutex + default values) */
+/* Initializes the controller (default values) */
 void env_controller_init(void);
 
+/* Copies a consistent snapshot; returns its generation */
+uint32_t env_controller_read(env_state_t *out);
+
+/* Generation of the latest completed write (cheap change check) */
+uint32_t env_controller_generation(void);
+
+/* Single-field readers */
+env_mode_t env_controller_get_mode(void);
+void env_controller_get_setpoints(env_setpoints_t *out);
+void env_controller_get_measurements(env_measurements_t *out);
+
+/* Writers (mode, setpoints and measurements are also published on
+ * their zbus channel when the value changes, see app_channels.h).
+ * 'trigger_cycles' is the k_cycle_get_32() of what caused the change,
+ * the sensor sample or the command line, carried in the message so
+ * actuation latency is measured from there. */
+void env_controller_set_mode(env_mode_t mode);
+env_mode_t env_controller_toggle_mode(void);    /* Returns the new mode */
+void env_controller_set_setpoints(const env_setpoints_t *sp, uint32_t trigger_cycles);
+void env_controller_set_measurements(const env_measurements_t *m, uint32_t trigger_cycles);
+
+void env_controller_get_stats(env_controller_stats_t *out);
+
 #endif /* ENV_CONTROLLER_H */
@@ -0,0 +1,150 @@
+/**
+ * @file irrigation.c
+ * @brief Time-proportioned (slow PWM) irrigation pump
+ */
+
+#include <zephyr/kernel.h>
+#include "irrigation.h"
+#include "actuator_output.h"
+
+static struct k_spinlock irr_lock;
+static irrigation_stats_t stats;
+static uint32_t fraction;
+static bool pulsing;
+static bool enabled;
+static int64_t last_track_ms;
+static uint64_t overshoot_ms;
+
+/* Ends a pulse: pump off (irr_lock held) */
+static void end_pulse(void)
+{
+    if (pulsing) {
+        actuator_output_set(ACTUATOR_IRRIGATION, false);
+        pulsing = false;
+    }
+}
+
+/* Starts a pulse: pump on (irr_lock held) */
+static void start_pulse(void)
+{
+    actuator_output_set(ACTUATOR_IRRIGATION, true);
+    pulsing = true;
+    stats.pulses++;
+}
+
+/* Both expiry handlers may run after irrigation_enable(false) dropped
+ * the lock but before it stopped the timers: 'enabled' is checked under
+ * the lock, so a late expiry never takes the pump back */
+static void pulse_timer_expiry(struct k_timer *timer)
+{
+    k_spinlock_key_t key = k_spin_lock(&irr_lock);
+
+    if (enabled) {
+        end_pulse();
+    }
+    k_spin_unlock(&irr_lock, key);
+}
+
+K_TIMER_DEFINE(pulse_timer, pulse_timer_expiry, NULL);
+
+/* Start of a window: switch on for fraction * window */
+static void window_timer_expiry(struct k_timer *timer)
+{
+    k_spinlock_key_t key = k_spin_lock(&irr_lock);
+    uint32_t on_ms = (uint32_t)((uint64_t)IRRIGATION_WINDOW_MS * fraction / 1000U);
+
+    if (!enabled) {
+        k_spin_unlock(&irr_lock, key);
+        return;
+    }
+
+    stats.windows++;
+
+    if (on_ms >= IRRIGATION_WINDOW_MS) {
+        /* Full demand: stay on across the window boundary */
+        if (!pulsing) {
+            start_pulse();
+        }
+        k_timer_stop(&pulse_timer);
+    } else if (on_ms >= IRRIGATION_MIN_PULSE_MS) {
+        /* Coming from full demand the pump is on already: keep it on
+         * rather than switching it off and straight back on */
+        if (!pulsing) {
+            start_pulse();
+        }
+        k_timer_start(&pulse_timer, K_MSEC(on_ms), K_NO_WAIT);
+    } else {
+        end_pulse();
+    }
+
+    k_spin_unlock(&irr_lock, key);
+}
+
+K_TIMER_DEFINE(window_timer, window_timer_expiry, NULL);
+
+void irrigation_enable(bool enable)
+{
+    k_spinlock_key_t key = k_spin_lock(&irr_lock);
+
+    if (enable == enabled) {
+        k_spin_unlock(&irr_lock, key);
+        return;
+    }
+    enabled = enable;
+    if (!enable) {
+        end_pulse();
+    }
+    k_spin_unlock(&irr_lock, key);
+
+    if (enable) {
+        k_timer_start(&window_timer, K_NO_WAIT, K_MSEC(IRRIGATION_WINDOW_MS));
+    } else {
+        k_timer_stop(&window_timer);
+        k_timer_stop(&pulse_timer);
+    }
+}
+
+bool irrigation_is_enabled(void)
+{
+    return enabled;
+}
+
+void irrigation_set_fraction(uint32_t permille)
+{
+    k_spinlock_key_t key = k_spin_lock(&irr_lock);
+    fraction = MIN(permille, 1000U);
+    stats.fraction_permille = fraction;
+    k_spin_unlock(&irr_lock, key);
+}
+
+void irrigation_track(float humidity, float target, int64_t now_ms)
+{
+    float over = humidity - target;
+    k_spinlock_key_t key = k_spin_lock(&irr_lock);
+
+    if (over > stats.overshoot_max) {
+        stats.overshoot_max = over;
+    }
+    if (last_track_ms != 0 && over > IRRIGATION_OVERSHOOT_BAND) {
+        overshoot_ms += (uint64_t)(now_ms - last_track_ms);
+        stats.overshoot_s = (uint32_t)(overshoot_ms / 1000U);
+    }
+    last_track_ms = now_ms;
+
+    k_spin_unlock(&irr_lock, key);
+}
+
+void irrigation_get_stats(irrigation_stats_t *out)
+{
+    actuator_usage_t usage;
+    k_spinlock_key_t key = k_spin_lock(&irr_lock);
+
+    *out = stats;
+    k_spin_unlock(&irr_lock, key);
+
+    /* Water follows the pump pin, whoever switched it: pulses, on/off
+     * control, rules or an auto-tune run */
+    actuator_output_get_usage(ACTUATOR_IRRIGATION, &usage);
+    out->on_ms = usage.on_ms;
+    out->water_ml = (uint32_t)(usage.on_ms * IRRIGATION_FLOW_ML_PER_MIN / 60000U);
+}
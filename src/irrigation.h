@@ -0,0 +1,45 @@
+/**
+ * @file irrigation.h
+ * @brief Time-proportioned (slow PWM) irrigation pump
+ *
+ * Every IRRIGATION_WINDOW_MS a window timer switches the pump on, and
+ * a one-shot timer switches it off after the commanded fraction of the
+ * window. Both run in timer context: the control thread only updates
+ * the fraction, it never wakes up to switch the pump.
+ */
+
+#ifndef IRRIGATION_H
+#define IRRIGATION_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define IRRIGATION_WINDOW_MS        60000
+#define IRRIGATION_MIN_PULSE_MS     2000        /* Shorter pulses are skipped */
+#define IRRIGATION_FLOW_ML_PER_MIN  500         /* Pump delivery, for water use */
+
+typedef struct {
+    uint32_t windows;
+    uint32_t pulses;
+    uint64_t on_ms;                 /* Pump on-time from any source (actuator usage) */
+    uint32_t water_ml;              /* on_ms at IRRIGATION_FLOW_ML_PER_MIN */
+    uint32_t fraction_permille;     /* Current commanded on-fraction */
+    float overshoot_max;            /* Largest humidity above target, %RH */
+    uint32_t overshoot_s;           /* Time spent > IRRIGATION_OVERSHOOT_BAND above */
+} irrigation_stats_t;
+
+#define IRRIGATION_OVERSHOOT_BAND   2.0f        /* %RH */
+
+/* Starts (or stops) the window timer; stopping switches the pump off */
+void irrigation_enable(bool enable);
+bool irrigation_is_enabled(void);
+
+/* On-fraction for the next windows, 0..1000 permille */
+void irrigation_set_fraction(uint32_t permille);
+
+/* Feeds the humidity and its target for the overshoot statistics */
+void irrigation_track(float humidity, float target, int64_t now_ms);
+
+void irrigation_get_stats(irrigation_stats_t *out);
+
+#endif /* IRRIGATION_H */
@@ -0,0 +1,122 @@
+/**
+ * @file loop_timing.c
+ * @brief Jitter and overrun statistics of the periodic control cycle
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+#include "loop_timing.h"
+
+const uint32_t loop_timing_bin_us[LOOP_TIMING_BINS] = {
+    100, 250, 500, 1000, 2000, 5000, 20000, UINT32_MAX
+};
+
+static struct k_spinlock timing_lock;
+static loop_timing_stats_t stats;
+static uint64_t busy_sum_us;
+
+static uint32_t period_cyc;
+static uint32_t deadline_cyc;       /* Ideal release of the current cycle */
+static uint32_t start_cyc;
+static bool anchored;
+
+void loop_timing_init(uint32_t period_ms)
+{
+    k_spinlock_key_t key = k_spin_lock(&timing_lock);
+
+    period_cyc = k_ms_to_cyc_floor32(period_ms);
+    anchored = false;
+    memset(&stats, 0, sizeof(stats));
+    busy_sum_us = 0;
+
+    k_spin_unlock(&timing_lock, key);
+}
+
+void loop_timing_cycle_start(uint32_t expirations)
+{
+    uint32_t now = k_cycle_get_32();
+    uint32_t late_us = 0;
+    int bin;
+
+    start_cyc = now;
+
+    if (!anchored) {
+        /* First release defines the deadline grid */
+        deadline_cyc = now;
+        anchored = true;
+        expirations = 1;
+    } else {
+        if (expirations == 0) {
+            expirations = 1;
+        }
+        deadline_cyc += period_cyc * expirations;
+        /* Wrapping difference; a release before its deadline counts as 0 */
+        if ((int32_t)(now - deadline_cyc) > 0) {
+            late_us = k_cyc_to_us_floor32(now - deadline_cyc);
+        }
+    }
+
+    for (bin = 0; bin < LOOP_TIMING_BINS - 1; bin++) {
+        if (late_us < loop_timing_bin_us[bin]) {
+            break;
+        }
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&timing_lock);
+    stats.cycles++;
+    stats.missed += expirations - 1;
+    stats.hist[bin]++;
+    if (late_us > stats.jitter_max_us) {
+        stats.jitter_max_us = late_us;
+    }
+    k_spin_unlock(&timing_lock, key);
+}
+
+void loop_timing_cycle_end(void)
+{
+    uint32_t busy = k_cycle_get_32() - start_cyc;
+    uint32_t busy_us = k_cyc_to_us_floor32(busy);
+
+    k_spinlock_key_t key = k_spin_lock(&timing_lock);
+    busy_sum_us += busy_us;
+    if (busy_us > stats.busy_max_us) {
+        stats.busy_max_us = busy_us;
+    }
+    if (busy > period_cyc) {
+        stats.overruns++;
+    }
+    k_spin_unlock(&timing_lock, key);
+}
+
+void loop_timing_get(loop_timing_stats_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&timing_lock);
+
+    *out = stats;
+    out->busy_avg_us = stats.cycles ? (uint32_t)(busy_sum_us / stats.cycles) : 0;
+
+    k_spin_unlock(&timing_lock, key);
+}
+
+void loop_timing_print(void)
+{
+    loop_timing_stats_t st;
+
+    loop_timing_get(&st);
+
+    printk("Cycle: n=%u missed=%u overruns=%u jitter max=%u us busy avg/max=%u/%u us\n",
+           (unsigned int)st.cycles, (unsigned int)st.missed,
+           (unsigned int)st.overruns, (unsigned int)st.jitter_max_us,
+           (unsigned int)st.busy_avg_us, (unsigned int)st.busy_max_us);
+    printk("Jitter hist (us):");
+    for (int i = 0; i < LOOP_TIMING_BINS; i++) {
+        if (i < LOOP_TIMING_BINS - 1) {
+            printk(" <%u:%u", (unsigned int)loop_timing_bin_us[i],
+                   (unsigned int)st.hist[i]);
+        } else {
+            printk(" more:%u", (unsigned int)st.hist[i]);
+        }
+    }
+    printk("\n");
+}
@@ -0,0 +1,48 @@
+/**
+ * @file loop_timing.h
+ * @brief Jitter and overrun statistics of the periodic control cycle
+ *
+ * The cycle is released by a periodic k_timer, so its deadlines are
+ * absolute: work time never shifts the next release. Each cycle records
+ * how late it started against its ideal deadline (jitter histogram),
+ * how long it ran, and whether timer periods were missed.
+ */
+
+#ifndef LOOP_TIMING_H
+#define LOOP_TIMING_H
+
+#include <stdint.h>
+
+/* Jitter histogram: bin i holds lateness below loop_timing_bin_us[i],
+ * the last bin everything above */
+#define LOOP_TIMING_BINS  8
+
+typedef struct {
+    uint32_t cycles;
+    uint32_t missed;            /* Timer periods skipped (no cycle ran) */
+    uint32_t overruns;          /* Cycles whose work exceeded the period */
+    uint32_t jitter_max_us;
+    uint32_t busy_max_us;       /* Longest cycle work time */
+    uint32_t busy_avg_us;
+    uint32_t hist[LOOP_TIMING_BINS];
+} loop_timing_stats_t;
+
+/* Upper bound of each histogram bin (last one is open) */
+extern const uint32_t loop_timing_bin_us[LOOP_TIMING_BINS];
+
+/* Sets the cycle period; the first cycle_start anchors the deadlines */
+void loop_timing_init(uint32_t period_ms);
+
+/* Call when a cycle is released; 'expirations' is the number of timer
+ * periods elapsed since the previous release (k_timer_status_*) */
+void loop_timing_cycle_start(uint32_t expirations);
+
+/* Call when the cycle's work is done */
+void loop_timing_cycle_end(void);
+
+void loop_timing_get(loop_timing_stats_t *out);
+
+/* One-line summary on the console */
+void loop_timing_print(void);
+
+#endif /* LOOP_TIMING_H */
@@ -8,6 +8,7 @@
 #include <zephyr/device.h>
 #include <zephyr/drivers/spi.h>
 #include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
 #include "SPI_LCD/spi_lcd_nokia.h"
 #include "SPI_LCD/lcd_nokia_images.h"
 #include "SPI_LCD/lcd_nokia_draw.h"
@@ -104,35 +105,309 @@
 
 #include "display_manager.h"
 #include "sensor_manager.h"
+#include "stats_rollup.h"
+#include "quantile_sketch.h"
+#include "env_controller.h"
+#include "adjust_manager.h"
+#include "mode_controller.h"
+#include "uart_bt.h"
+#include "loop_timing.h"
+#include "schedule.h"
+#include "trend.h"
+#include "trace.h"
+#ifdef CONFIG_GREENHOUSE_REPLAY
+#include "sim/trace_replay.h"
+#endif
+#ifdef CONFIG_GREENHOUSE_SIM_TESTING
+#include "sim/sim_test.h"
+#endif
 
 /* Update period for sensor readings (ms) */
 #define SENSOR_UPDATE_MS   1000
 
-/* Global mode variable — kept simple for now */
-static system_mode_t current_mode = MODE_READ_ONLY;
+/* Cycle timing summary on the console every N cycles */
+#define TIMING_PRINT_CYCLES  60
 
-/* Converts sensor_data_t into display_data_t for the display manager */
-static void convert_sensor_to_display(const sensor_data_t *sens, display_data_t *disp)
+/* Display pages: live readings, one aggregate page per channel, then
+ * actuator usage */
+#define DISPLAY_PAGE_CYCLES  5      /* Update cycles each page stays visible */
+#define DISPLAY_PAGE_USAGE   (1 + SENSOR_CH_COUNT)
+#define DISPLAY_PAGE_COUNT   (DISPLAY_PAGE_USAGE + 1)
+
+#ifdef CONFIG_GREENHOUSE_REACTOR
+/* Single event loop on the main thread: button, Bluetooth, sensor
+ * timer and display events are dispatched from one stack */
+enum {
+    REACTOR_EV_BUTTON,
+    REACTOR_EV_SENSOR,
+    REACTOR_EV_DISPLAY,
+    REACTOR_EV_BT,                  /* UART_BT_POLL_EVENTS entries */
+    REACTOR_EV_COUNT = REACTOR_EV_BT + UART_BT_POLL_EVENTS
+};
+
+static struct k_poll_signal sensor_tick = K_POLL_SIGNAL_INITIALIZER(sensor_tick);
+
+static void sensor_timer_expiry(struct k_timer *timer)
+{
+    k_poll_signal_raise(&sensor_tick, 0);
+}
+
+/* Periodic release of the sensor cycle on absolute deadlines */
+K_TIMER_DEFINE(sensor_timer, sensor_timer_expiry, NULL);
+
+#define WORKER_STACK_BYTES  0
+#else
+/* Worker threads */
+#define BT_THREAD_STACK_SIZE     2048
+#define MODE_THREAD_STACK_SIZE   1024
+#define WORKER_THREAD_PRIORITY   5
+
+K_THREAD_STACK_DEFINE(bt_thread_stack, BT_THREAD_STACK_SIZE);
+K_THREAD_STACK_DEFINE(mode_thread_stack, MODE_THREAD_STACK_SIZE);
+static struct k_thread bt_thread_data;
+static struct k_thread mode_thread_data;
+
+#define WORKER_STACK_BYTES  (BT_THREAD_STACK_SIZE + MODE_THREAD_STACK_SIZE + \
+                             2 * sizeof(struct k_thread))
+
+/* Periodic release of the sensor cycle on absolute deadlines */
+K_TIMER_DEFINE(sensor_timer, NULL, NULL);
+#endif
+
+/* Sensor cycle counter; the display work reads the value of the
+ * cycle it was submitted for */
+static uint32_t sensor_cycle;
+static atomic_t display_cycle;
+
+#ifdef CONFIG_GREENHOUSE_REPLAY
+/* Replayed samples bypass the sensor manager: age them here */
+static uint32_t replay_valid_ms[SENSOR_CH_COUNT];
+static bool replay_seen[SENSOR_CH_COUNT];
+
+static bool channel_stale(const sensor_data_t *sens, sensor_ch_t ch)
+{
+    if (sens->valid[ch]) {
+        replay_valid_ms[ch] = sens->timestamp;
+        replay_seen[ch] = true;
+    }
+    return !replay_seen[ch] || sens->timestamp - replay_valid_ms[ch] > SENSOR_STALE_MS;
+}
+#else
+static bool channel_stale(const sensor_data_t *sens, sensor_ch_t ch)
 {
-    /* Copy values even if some are invalid; display manager will show them as-is */
-    disp->temperature = sens->temperature;
-    disp->light_level = sens->light_level;
-    disp->humidity    = sens->humidity;
-    disp->mode        = current_mode;
+    ARG_UNUSED(sens);
+    return sensor_manager_is_stale(ch);
 }
+#endif
 
-/* Process sensor errors (optional future expansion) */
-static void log_sensor_status(const sensor_data_t *data)
+/* Publishes valid channels to the shared controller state; invalid
+ * ones keep their last published value and are flagged once stale */
+static void publish_measurements(const sensor_data_t *sens)
 {
-    if (!data->temperature_valid) {
-        printk("Warning: Temperature reading invalid\n");
+    env_measurements_t m;
+    float value;
+
+    env_controller_get_measurements(&m);
+
+    m.stale = 0;
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        if (channel_stale(sens, (sensor_ch_t)ch)) {
+            m.stale |= BIT(ch);
+        }
+    }
+
+    if (sensor_data_get_channel(sens, SENSOR_CH_TEMPERATURE, &value)) {
+        m.temperature = value;
     }
-    if (!data->light_valid) {
-        printk("Warning: Light reading invalid\n");
+    if (sensor_data_get_channel(sens, SENSOR_CH_HUMIDITY, &value)) {
+        m.humidity = value;
     }
-    if (!data->humidity_valid) {
-        printk("Warning: Humidity reading invalid\n");
+    if (sensor_data_get_channel(sens, SENSOR_CH_LIGHT, &value)) {
+        m.light = value;
     }
+
+    env_controller_set_measurements(&m, sens->sample_cycles);
+}
+
+/* Reports channels whose last valid sample is too old. Transient
+ * failures are absorbed by the sensor manager's retry backoff. */
+static void log_sensor_status(void)
+{
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        if (sensor_manager_is_stale((sensor_ch_t)ch)) {
+            printk("Warning: %s data stale\n", sensor_channel_name((sensor_ch_t)ch));
+        }
+    }
+}
+
+/* Shows the live, an aggregate or the usage page. The live page is
+ * redrawn only when new data was published or the page just came up. */
+static void update_display_page(uint32_t cycle)
+{
+    uint32_t page = (cycle / DISPLAY_PAGE_CYCLES) % DISPLAY_PAGE_COUNT;
+
+    if (page == 0) {
+        display_refresh(cycle % DISPLAY_PAGE_CYCLES == 0);
+    } else if (page == DISPLAY_PAGE_USAGE) {
+        display_show_usage();
+    } else {
+        display_show_stats((sensor_ch_t)(page - 1), STATS_WIN_HOUR);
+    }
+}
+
+/*
+ * Display work runs on the system work queue: SPI drawing of one cycle
+ * overlaps the acquisition of the next instead of delaying it, and the
+ * LCD is only ever touched from that one thread.
+ */
+static void display_page_work_handler(struct k_work *work)
+{
+    update_display_page((uint32_t)atomic_get(&display_cycle));
+}
+
+K_WORK_DEFINE(display_page_work, display_page_work_handler);
+
+/* One sensor period: read, publish, aggregate, hand off the screen */
+static void run_sensor_cycle(void)
+{
+    sensor_data_t sens = {0};
+
+#ifdef CONFIG_GREENHOUSE_REPLAY
+    /* Recorded samples instead of the sensors, paced by the trace */
+    trace_replay_next(&sens);
+    sens.sample_cycles = k_cycle_get_32();
+#else
+    /* Read all sensors */
+    if (sensor_manager_read_all(&sens) != 0) {
+        printk("ERROR reading sensors: %s\n", sensor_manager_get_error());
+    }
+    trace_record_sample(&sens);
+
+    /* Optional debug information */
+    log_sensor_status();
+#endif
+
+    /* Trends first: feed-forward control reads them on the publish */
+    trend_add_data(&sens);
+
+    /* Share the new readings with the controller */
+    publish_measurements(&sens);
+
+    /* Feed the minute/hour/day aggregates */
+    stats_rollup_add_data(&sens);
+    quantile_sketch_add_data(&sens);
+
+    /* Update the screen (no-op if the previous draw is still queued) */
+    atomic_set(&display_cycle, (atomic_val_t)sensor_cycle++);
+    k_work_submit(&display_page_work);
+
+    if (sensor_cycle % TIMING_PRINT_CYCLES == 0) {
+        loop_timing_print();
+    }
+}
+
+/* Runs one released cycle; 'expirations' timer periods have elapsed */
+static void run_timed_cycle(uint32_t expirations)
+{
+    loop_timing_cycle_start(expirations);
+    run_sensor_cycle();
+    loop_timing_cycle_end();
+}
+
+#ifdef CONFIG_GREENHOUSE_REACTOR
+/* Redraws the live page when new data arrived between sensor cycles;
+ * aggregate pages are redrawn by the sensor cycle only */
+static void display_live_work_handler(struct k_work *work)
+{
+    uint32_t cycle = (uint32_t)atomic_get(&display_cycle);
+
+    if ((cycle / DISPLAY_PAGE_CYCLES) % DISPLAY_PAGE_COUNT == 0) {
+        display_refresh(false);
+    }
+}
+
+K_WORK_DEFINE(display_live_work, display_live_work_handler);
+
+/* Never returns: waits on every event source and dispatches handlers */
+static void run_reactor(void)
+{
+    struct k_poll_event events[REACTOR_EV_COUNT];
+
+    mode_controller_init_poll_event(&events[REACTOR_EV_BUTTON]);
+    k_poll_event_init(&events[REACTOR_EV_SENSOR], K_POLL_TYPE_SIGNAL,
+                      K_POLL_MODE_NOTIFY_ONLY, &sensor_tick);
+    display_init_poll_event(&events[REACTOR_EV_DISPLAY]);
+    uart_bt_init_poll_events(&events[REACTOR_EV_BT]);
+
+    while (1) {
+        k_poll(events, ARRAY_SIZE(events), K_FOREVER);
+
+        if (events[REACTOR_EV_BUTTON].state != K_POLL_STATE_NOT_READY) {
+            events[REACTOR_EV_BUTTON].state = K_POLL_STATE_NOT_READY;
+            mode_controller_process();
+        }
+
+        if (events[REACTOR_EV_SENSOR].state != K_POLL_STATE_NOT_READY) {
+            events[REACTOR_EV_SENSOR].state = K_POLL_STATE_NOT_READY;
+            k_poll_signal_reset(&sensor_tick);
+            run_timed_cycle(k_timer_status_get(&sensor_timer));
+        }
+
+        /* Bluetooth before the display: replies are latency sensitive */
+        uart_bt_process(&events[REACTOR_EV_BT]);
+
+        if (events[REACTOR_EV_DISPLAY].state != K_POLL_STATE_NOT_READY) {
+            events[REACTOR_EV_DISPLAY].state = K_POLL_STATE_NOT_READY;
+            k_poll_signal_reset(events[REACTOR_EV_DISPLAY].signal);
+            k_work_submit(&display_live_work);
+        }
+    }
+}
+#endif
+
+/* Starts the controller, button and Bluetooth workers */
+static void start_workers(void)
+{
+    env_controller_init();
+    if (adjust_manager_init() != 0) {
+        printk("ERROR: Actuators unavailable, control is off\n");
+    }
+
+#ifdef CONFIG_SETTINGS
+    /* Stored controller gains (and other persisted settings) */
+    if (settings_subsys_init() == 0) {
+        settings_load();
+    } else {
+        printk("Settings unavailable, using defaults\n");
+    }
+#endif
+
+    /* Applies the stored (or empty) setpoint schedule */
+    schedule_start();
+
+#ifdef CONFIG_GREENHOUSE_REACTOR
+    mode_controller_init();
+    uart_bt_init();
+    uart_bt_start();
+#else
+    if (mode_controller_init() == 0) {
+        k_thread_create(&mode_thread_data, mode_thread_stack,
+                        K_THREAD_STACK_SIZEOF(mode_thread_stack),
+                        mode_controller_thread, NULL, NULL, NULL,
+                        WORKER_THREAD_PRIORITY, 0, K_NO_WAIT);
+        k_thread_name_set(&mode_thread_data, "mode");
+    }
+
+    k_thread_create(&bt_thread_data, bt_thread_stack,
+                    K_THREAD_STACK_SIZEOF(bt_thread_stack),
+                    uart_bt_thread, NULL, NULL, NULL,
+                    WORKER_THREAD_PRIORITY, 0, K_NO_WAIT);
+    k_thread_name_set(&bt_thread_data, "bt");
+#endif
+
+    /* Compare layouts: worker stacks + thread objects, and the main stack */
+    printk("Worker RAM: %u bytes, main stack: %u bytes\n",
+           (unsigned int)WORKER_STACK_BYTES, (unsigned int)CONFIG_MAIN_STACK_SIZE);
 }
 
 int main(void)
@@ -160,27 +435,38 @@ int main(void)
         printk("Sensors initialized successfully\n");
     }
 
-    /* Main loop */
-    while (1) {
-        sensor_data_t sens;
-        display_data_t disp;
+    stats_rollup_init();
+    trend_init();
+    quantile_sketch_init();
+    start_workers();
 
-        /* Read all sensors */
-        if (sensor_manager_read_all(&sens) != 0) {
-            printk("ERROR reading sensors: %s\n", sensor_manager_get_error());
-        }
+    /* The timer keeps an absolute period: cycle work and its jitter
+     * never push back the next release */
+    loop_timing_init(SENSOR_UPDATE_MS);
 
-        /* Optional debug information */
-        log_sensor_status(&sens);
+#ifdef CONFIG_GREENHOUSE_SIM_TESTING
+    /* Module tests end here; closed-loop tests run next to the loop */
+    sim_test_start();
+#endif
 
-        /* Convert sensor structure into the display structure */
-        convert_sensor_to_display(&sens, &disp);
+#ifdef CONFIG_GREENHOUSE_REPLAY
+    /* The trace sets the pace: no period timer */
+    while (1) {
+        run_timed_cycle(1);
+    }
+#endif
 
-        /* Update the screen */
-        display_update(&disp);
+    k_timer_start(&sensor_timer, K_NO_WAIT, K_MSEC(SENSOR_UPDATE_MS));
 
-        k_msleep(SENSOR_UPDATE_MS);
+#ifdef CONFIG_GREENHOUSE_REACTOR
+    run_reactor();
+#else
+    /* Main loop */
+    while (1) {
+        /* Blocks until the next tick; more than 1 means periods were missed */
+        run_timed_cycle(k_timer_status_sync(&sensor_timer));
     }
+#endif
 
     return 0;
 }
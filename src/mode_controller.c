@@ -6,6 +6,7 @@
 #include "mode_controller.h"
 #include "display_manager.h"
 #include "env_controller.h"
+#include "app_channels.h"
 
 /* Button and LED aliases must exist in the board overlay */
 #define BUTTON_NODE DT_ALIAS(sw0)
@@ -17,12 +18,14 @@ static struct gpio_dt_spec led = GPIO_DT_SPEC_GET(LED_NODE, gpios);
 
 static struct gpio_callback button_cb;
 K_SEM_DEFINE(button_sem, 0, 1);
+static volatile uint32_t press_cycles;
 
 /* Interrupt callback for button press */
 static void button_pressed(const struct device *dev,
                            struct gpio_callback *cb,
                            uint32_t pins)
 {
+    press_cycles = k_cycle_get_32();
     k_sem_give(&button_sem);
 }
 
@@ -50,38 +53,57 @@ int mode_controller_init(void)
     return 0;
 }
 
-/* Update global mode safely and notify display */
-void mode_controller_set_mode(env_mode_t new_mode)
+/* Mirrors a mode change on the LED and the console */
+static void mode_controller_show_mode(env_mode_t mode)
 {
-    k_mutex_lock(&env.lock, K_FOREVER);
-    env.mode = new_mode;
-    k_mutex_unlock(&env.lock);
-
     /* Update LED based on mode */
-    gpio_pin_set_dt(&led, (new_mode == ENV_MODE_ADJUSTING));
+    gpio_pin_set_dt(&led, (mode == ENV_MODE_ADJUSTING));
 
     /* Print debug info */
-    if (new_mode == ENV_MODE_READ_ONLY) {
+    if (mode == ENV_MODE_READ_ONLY) {
         printk("System mode set to READ_ONLY\n");
     } else {
         printk("System mode set to ADJUSTING\n");
     }
 }
 
+/* Update global mode and notify */
+void mode_controller_set_mode(env_mode_t new_mode)
+{
+    env_controller_set_mode(new_mode);
+    mode_controller_show_mode(new_mode);
+}
+
+void mode_controller_init_poll_event(struct k_poll_event *event)
+{
+    k_poll_event_init(event, K_POLL_TYPE_SEM_AVAILABLE,
+                      K_POLL_MODE_NOTIFY_ONLY, &button_sem);
+}
+
+/* Handles a pending button press, if any */
+void mode_controller_process(void)
+{
+    if (k_sem_take(&button_sem, K_NO_WAIT) != 0) {
+        return;
+    }
+
+    /* Press-to-handler latency */
+    app_channels_note_event_latency(press_cycles);
+
+    /* Toggle mode (atomic read-modify-write) */
+    mode_controller_show_mode(env_controller_toggle_mode());
+}
+
 /* Thread: waits for button press and toggles mode */
 void mode_controller_thread(void *p1, void *p2, void *p3)
 {
-    while (1) {
-        k_sem_take(&button_sem, K_FOREVER);
+    struct k_poll_event event;
 
-        /* Toggle mode */
-        k_mutex_lock(&env.lock, K_FOREVER);
-        env_mode_t current = env.mode;
-        env_mode_t new_mode = 
-            (current == ENV_MODE_READ_ONLY) ?
-            ENV_MODE_ADJUSTING : ENV_MODE_READ_ONLY;
-        k_mutex_unlock(&env.lock);
+    mode_controller_init_poll_event(&event);
 
-        mode_controller_set_mode(new_mode);
+    while (1) {
+        k_poll(&event, 1, K_FOREVER);
+        event.state = K_POLL_STATE_NOT_READY;
+        mode_controller_process();
     }
 }
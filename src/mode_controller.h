@@ -10,6 +10,11 @@ int mode_controller_init(void);
 /* Explicitly sets the system mode */
 void mode_controller_set_mode(env_mode_t new_mode);
 
+/* Poll event that becomes ready on a button press, and its handler
+ * (used by the thread below or by the single-thread reactor) */
+void mode_controller_init_poll_event(struct k_poll_event *event);
+void mode_controller_process(void);
+
 /* Background thread that listens for button presses */
 void mode_controller_thread(void *p1, void *p2, void *p3);
 
@@ -0,0 +1,68 @@
+/**
+ * @file pid_ctrl.c
+ * @brief Fixed-point PID controller
+ */
+
+#include <zephyr/sys/util.h>
+#include "pid_ctrl.h"
+
+void pid_init(pid_ctrl_t *pid, const pid_params_t *params)
+{
+    pid->p = *params;
+    pid_reset(pid);
+}
+
+void pid_reset(pid_ctrl_t *pid)
+{
+    pid->integral = 0;
+    pid->prev_input = 0;
+    pid->d_rate = 0;
+    pid->output = pid->p.out_min;
+    pid->primed = false;
+}
+
+void pid_set_gains(pid_ctrl_t *pid, int32_t kp, int32_t ki, int32_t kd)
+{
+    pid->p.kp = kp;
+    pid->p.ki = ki;
+    pid->p.kd = kd;
+}
+
+int32_t pid_update(pid_ctrl_t *pid, int32_t setpoint, int32_t input, uint32_t dt_ms)
+{
+    const pid_params_t *p = &pid->p;
+    const int64_t min_q = (int64_t)p->out_min << 16;
+    const int64_t max_q = (int64_t)p->out_max << 16;
+    int32_t error = p->reverse ? input - setpoint : setpoint - input;
+    int64_t p_term, d_term, integral, out;
+
+    if (dt_ms == 0) {
+        return pid->output;
+    }
+
+    /* Derivative on measurement, first-order low-pass filtered */
+    if (pid->primed) {
+        int32_t rate = (int32_t)((int64_t)(input - pid->prev_input) * 1000 / dt_ms);
+        pid->d_rate += (int32_t)(((int64_t)p->d_alpha * (rate - pid->d_rate)) >> 16);
+    }
+    pid->prev_input = input;
+    pid->primed = true;
+
+    p_term = (int64_t)p->kp * error;
+    /* d(error)/dt is minus the input rate for direct action */
+    d_term = (int64_t)p->kd * (p->reverse ? pid->d_rate : -pid->d_rate);
+
+    integral = pid->integral + (int64_t)p->ki * error * dt_ms / 1000;
+    integral = CLAMP(integral, min_q, max_q);
+
+    /* Conditional integration: don't wind further into saturation */
+    out = p_term + integral + d_term;
+    if ((out > max_q && error > 0) || (out < min_q && error < 0)) {
+        integral = pid->integral;
+        out = p_term + integral + d_term;
+    }
+    pid->integral = integral;
+
+    pid->output = (int32_t)(CLAMP(out, min_q, max_q) >> 16);
+    return pid->output;
+}
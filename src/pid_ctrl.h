@@ -0,0 +1,53 @@
+/**
+ * @file pid_ctrl.h
+ * @brief Fixed-point PID controller
+ *
+ * Integer-only PID: gains are Q16.16, the input is in milli-units
+ * (e.g. m°C) and the output in controller units (e.g. permille duty).
+ * The integral is clamped to the output range and frozen while the
+ * output saturates in the direction of the error (anti-windup). The
+ * derivative acts on the measurement, so setpoint steps do not kick,
+ * and is low-pass filtered.
+ */
+
+#ifndef PID_CTRL_H
+#define PID_CTRL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define PID_Q16_ONE        65536
+#define PID_TO_Q16(x)      ((int32_t)((x) * (float)PID_Q16_ONE))
+#define PID_FROM_Q16(q)    ((float)(q) / (float)PID_Q16_ONE)
+
+typedef struct {
+    int32_t kp;         /* Output per input unit, Q16.16 */
+    int32_t ki;         /* Output per input unit-second, Q16.16 */
+    int32_t kd;         /* Output per input unit/second, Q16.16 */
+    int32_t d_alpha;    /* Derivative filter coefficient (0, 1], Q16.16 */
+    int32_t out_min;
+    int32_t out_max;
+    bool reverse;       /* Output rises when the input is above the setpoint */
+} pid_params_t;
+
+typedef struct {
+    pid_params_t p;
+    int64_t integral;   /* Integral term, Q16.16 output units */
+    int32_t prev_input;
+    int32_t d_rate;     /* Filtered input rate, input units per second */
+    int32_t output;
+    bool primed;        /* prev_input valid */
+} pid_ctrl_t;
+
+void pid_init(pid_ctrl_t *pid, const pid_params_t *params);
+
+/* Clears the integral and derivative history (output goes to out_min) */
+void pid_reset(pid_ctrl_t *pid);
+
+/* Changes gains without a bump: the integral is kept */
+void pid_set_gains(pid_ctrl_t *pid, int32_t kp, int32_t ki, int32_t kd);
+
+/* One control step 'dt_ms' after the previous one; returns the output */
+int32_t pid_update(pid_ctrl_t *pid, int32_t setpoint, int32_t input, uint32_t dt_ms);
+
+#endif /* PID_CTRL_H */
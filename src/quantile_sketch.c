@@ -0,0 +1,190 @@
+/**
+ * @file quantile_sketch.c
+ * @brief Fixed-bin histogram percentile sketch per sensor channel
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+#include <math.h>
+#include "quantile_sketch.h"
+
+#define MS_PER_DAY  (24u * 60u * 60u * 1000u)
+
+/* Bins of a channel span its devicetree range. Log-scale channels
+ * (e.g. lux) keep relative error constant; the others use linear bins,
+ * e.g. 70 C / 128 = 0.55 C per bin for temperature. */
+static quantile_channel_t sketches[SENSOR_CH_COUNT];
+K_MUTEX_DEFINE(sketch_lock);
+
+/* Continuous bin position in [0, QUANTILE_BINS] for a value */
+static float value_to_pos(const quantile_channel_t *r, float value)
+{
+    float frac;
+
+    if (value <= r->lo) return 0.0f;
+    if (value >= r->hi) return (float)QUANTILE_BINS;
+
+    if (r->log_scale) {
+        frac = log1pf(value - r->lo) / log1pf(r->hi - r->lo);
+    } else {
+        frac = (value - r->lo) / (r->hi - r->lo);
+    }
+    return frac * (float)QUANTILE_BINS;
+}
+
+/* Inverse of value_to_pos */
+static float pos_to_value(const quantile_channel_t *r, float pos)
+{
+    float frac = pos / (float)QUANTILE_BINS;
+
+    if (r->log_scale) {
+        return r->lo + expm1f(frac * log1pf(r->hi - r->lo));
+    }
+    return r->lo + frac * (r->hi - r->lo);
+}
+
+/* Halves every bin so counts keep their proportions without overflowing */
+static void histogram_decay(quantile_histogram_t *h)
+{
+    h->total = 0;
+    for (int i = 0; i < QUANTILE_BINS; i++) {
+        h->bins[i] >>= 1;
+        h->total += h->bins[i];
+    }
+}
+
+/* Moves to a new uptime day, keeping the previous one if it was adjacent */
+static void sketch_roll_day(quantile_channel_t *s, uint32_t day)
+{
+    if (day == s->day + 1) {
+        s->yesterday = s->today;
+    } else {
+        memset(&s->yesterday, 0, sizeof(s->yesterday));
+    }
+    memset(&s->today, 0, sizeof(s->today));
+    s->day = day;
+}
+
+void quantile_sketch_init(void)
+{
+    k_mutex_lock(&sketch_lock, K_FOREVER);
+    memset(sketches, 0, sizeof(sketches));
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        const sensor_channel_info_t *info = sensor_channel_info((sensor_ch_t)ch);
+
+        sketches[ch].lo = (float)info->range_min;
+        sketches[ch].hi = (float)info->range_max;
+        sketches[ch].log_scale = info->log_scale;
+    }
+    k_mutex_unlock(&sketch_lock);
+}
+
+void quantile_sketch_add_sample(sensor_ch_t ch, float value, uint32_t timestamp_ms)
+{
+    if (ch >= SENSOR_CH_COUNT || value != value) { /* Reject NaN */
+        return;
+    }
+
+    quantile_channel_t *s = &sketches[ch];
+    uint32_t day = timestamp_ms / MS_PER_DAY;
+    int bin = (int)value_to_pos(&sketches[ch], value);
+
+    if (bin >= QUANTILE_BINS) {
+        bin = QUANTILE_BINS - 1;
+    }
+
+    k_mutex_lock(&sketch_lock, K_FOREVER);
+    if (day != s->day) {
+        sketch_roll_day(s, day);
+    }
+    if (s->today.bins[bin] == UINT16_MAX) {
+        histogram_decay(&s->today);
+    }
+    s->today.bins[bin]++;
+    s->today.total++;
+    k_mutex_unlock(&sketch_lock);
+}
+
+void quantile_sketch_add_data(const sensor_data_t *data)
+{
+    float value;
+
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        if (sensor_data_get_channel(data, (sensor_ch_t)ch, &value)) {
+            quantile_sketch_add_sample((sensor_ch_t)ch, value, data->timestamp);
+        }
+    }
+}
+
+/* Selects the histogram for a query, or NULL if the arguments are invalid */
+static const quantile_histogram_t *sketch_select(sensor_ch_t ch, quantile_day_t day)
+{
+    if (ch >= SENSOR_CH_COUNT) {
+        return NULL;
+    }
+    return (day == QUANTILE_DAY_TODAY) ? &sketches[ch].today : &sketches[ch].yesterday;
+}
+
+int quantile_sketch_percentile(sensor_ch_t ch, quantile_day_t day, float p, float *out)
+{
+    const quantile_histogram_t *h = sketch_select(ch, day);
+    int ret = -ENODATA;
+
+    if (!h || !out || p < 0.0f || p > 100.0f) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&sketch_lock, K_FOREVER);
+    if (h->total > 0) {
+        float target = p / 100.0f * (float)h->total;
+        uint32_t cum = 0;
+        int i;
+
+        /* Find the bin holding the target rank, interpolate inside it */
+        for (i = 0; i < QUANTILE_BINS - 1; i++) {
+            if ((float)(cum + h->bins[i]) >= target && h->bins[i] > 0) {
+                break;
+            }
+            cum += h->bins[i];
+        }
+
+        float inside = (h->bins[i] > 0) ? (target - (float)cum) / (float)h->bins[i] : 0.0f;
+        *out = pos_to_value(&sketches[ch], (float)i + CLAMP(inside, 0.0f, 1.0f));
+        ret = 0;
+    }
+    k_mutex_unlock(&sketch_lock);
+
+    return ret;
+}
+
+int quantile_sketch_fraction_below(sensor_ch_t ch, quantile_day_t day, float value,
+                                   float *out)
+{
+    const quantile_histogram_t *h = sketch_select(ch, day);
+    int ret = -ENODATA;
+
+    if (!h || !out) {
+        return -EINVAL;
+    }
+
+    float pos = value_to_pos(&sketches[ch], value);
+    int whole = (int)pos;
+
+    k_mutex_lock(&sketch_lock, K_FOREVER);
+    if (h->total > 0) {
+        float below = 0.0f;
+
+        for (int i = 0; i < whole && i < QUANTILE_BINS; i++) {
+            below += (float)h->bins[i];
+        }
+        if (whole < QUANTILE_BINS) {
+            below += (pos - (float)whole) * (float)h->bins[whole];
+        }
+
+        *out = below / (float)h->total;
+        ret = 0;
+    }
+    k_mutex_unlock(&sketch_lock);
+
+    return ret;
+}
@@ -0,0 +1,58 @@
+/**
+ * @file quantile_sketch.h
+ * @brief Fixed-memory daily percentile estimates per sensor channel
+ *
+ * Each channel owns a fixed-bin histogram for the current uptime day and
+ * a copy of the previous day. Bins span the channel's devicetree range
+ * (range-min / range-max, log-scale), so percentile error is bounded by
+ * one bin width.
+ */
+
+#ifndef QUANTILE_SKETCH_H
+#define QUANTILE_SKETCH_H
+
+#include <stdint.h>
+#include "sensor_manager.h"
+
+/* Bins per channel histogram */
+#define QUANTILE_BINS   128
+
+/* Sketch state, public only so its size is known at compile time */
+typedef struct {
+    uint16_t bins[QUANTILE_BINS];
+    uint32_t total;
+} quantile_histogram_t;
+
+typedef struct {
+    quantile_histogram_t today;
+    quantile_histogram_t yesterday;
+    uint32_t day;               /* Uptime day 'today' belongs to */
+    float lo, hi;               /* Bin range, from devicetree */
+    bool log_scale;
+} quantile_channel_t;
+
+/* Total static RAM used by the sketches */
+#define QUANTILE_SKETCH_RAM_BYTES  (SENSOR_CH_COUNT * sizeof(quantile_channel_t))
+
+typedef enum {
+    QUANTILE_DAY_TODAY = 0,
+    QUANTILE_DAY_YESTERDAY
+} quantile_day_t;
+
+/* Clears all histograms */
+void quantile_sketch_init(void);
+
+/* Adds one sample (timestamp from k_uptime_get_32) */
+void quantile_sketch_add_sample(sensor_ch_t ch, float value, uint32_t timestamp_ms);
+
+/* Adds every valid channel of a sensor snapshot */
+void quantile_sketch_add_data(const sensor_data_t *data);
+
+/* Estimates percentile p (0..100); returns 0 or -EINVAL / -ENODATA */
+int quantile_sketch_percentile(sensor_ch_t ch, quantile_day_t day, float p, float *out);
+
+/* Fraction (0..1) of samples below 'value'; returns 0 or -EINVAL / -ENODATA */
+int quantile_sketch_fraction_below(sensor_ch_t ch, quantile_day_t day, float value,
+                                   float *out);
+
+#endif /* QUANTILE_SKETCH_H */
@@ -0,0 +1,628 @@
+/**
+ * @file rule_engine.c
+ * @brief User automation rules compiled to a small stack bytecode
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/printk.h>
+#include <ctype.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include "rule_engine.h"
+#include "actuator_output.h"
+
+/* Bytecode: one opcode byte, PUSH followed by a float, LOAD by a
+ * variable index. No jumps, so the code length bounds the run time. */
+typedef enum {
+    OP_END = 0,
+    OP_PUSH,
+    OP_LOAD,
+    OP_ADD, OP_SUB, OP_MUL, OP_NEG,
+    OP_LT, OP_GT, OP_LE, OP_GE, OP_EQ, OP_NE,
+    OP_AND, OP_OR, OP_NOT,
+} rule_op_t;
+
+enum { VAR_TEMP, VAR_HUM, VAR_LUX, VAR_TSP, VAR_HSP, VAR_LSP, VAR_COUNT };
+
+static const char *const var_names[VAR_COUNT] = {
+    "TEMP", "HUM", "LUX", "TSP", "HSP", "LSP",
+};
+
+typedef struct {
+    char text[RULE_TEXT_MAX];
+    uint8_t code[RULE_CODE_MAX];
+    uint8_t code_len;
+    uint8_t actuator;
+    bool on;
+    uint16_t hold_s;
+
+    /* Run state and statistics */
+    bool was_true;
+    bool active;
+    int64_t hold_until_ms;
+    uint32_t fired;
+    uint32_t evals;
+    uint64_t eval_sum_ns;
+    uint32_t eval_max_ns;
+} rule_t;
+
+K_MUTEX_DEFINE(rule_lock);
+
+static rule_t rules[RULE_MAX];
+static int rule_count;
+
+/* ---- Compiler: recursive descent straight into the rule's code ---- */
+
+#define MAX_NESTING 8
+
+typedef struct {
+    const char *p;
+    rule_t *rule;
+    int depth;                  /* Stack depth at this point of the code */
+    int nesting;
+    const char *err;
+} compiler_t;
+
+static bool fail(compiler_t *c, const char *msg)
+{
+    if (!c->err) {
+        c->err = msg;
+    }
+    return false;
+}
+
+static void skip_spaces(compiler_t *c)
+{
+    while (*c->p == ' ' || *c->p == '\t') {
+        c->p++;
+    }
+}
+
+/* Consumes 'tok' (symbols) if it comes next */
+static bool match(compiler_t *c, const char *tok)
+{
+    size_t n = strlen(tok);
+
+    skip_spaces(c);
+    if (strncmp(c->p, tok, n) != 0) {
+        return false;
+    }
+    c->p += n;
+    return true;
+}
+
+/* Consumes the keyword 'word' (any case, whole word) if it comes next */
+static bool match_word(compiler_t *c, const char *word)
+{
+    const char *s;
+
+    skip_spaces(c);
+    for (s = c->p; *word; s++, word++) {
+        if (toupper((unsigned char)*s) != *word) {
+            return false;
+        }
+    }
+    if (isalnum((unsigned char)*s)) {
+        return false;
+    }
+    c->p = s;
+    return true;
+}
+
+/* Appends an opcode with 'arg_len' argument bytes; 'push' is its net
+ * effect on the stack depth */
+static bool emit(compiler_t *c, rule_op_t op, const void *arg, size_t arg_len, int push)
+{
+    rule_t *r = c->rule;
+
+    /* One byte stays reserved for OP_END */
+    if (r->code_len + 1 + arg_len >= RULE_CODE_MAX) {
+        return fail(c, "rule too complex");
+    }
+    c->depth += push;
+    if (c->depth > RULE_STACK_DEPTH) {
+        return fail(c, "nested too deep");
+    }
+
+    r->code[r->code_len++] = (uint8_t)op;
+    if (arg_len > 0) {
+        memcpy(&r->code[r->code_len], arg, arg_len);
+        r->code_len += arg_len;
+    }
+    return true;
+}
+
+/* Consumes a minus sign, but not the '-' of "->" */
+static bool match_minus(compiler_t *c)
+{
+    skip_spaces(c);
+    if (c->p[0] != '-' || c->p[1] == '>') {
+        return false;
+    }
+    c->p++;
+    return true;
+}
+
+static bool parse_or(compiler_t *c);
+
+static bool parse_primary(compiler_t *c)
+{
+    skip_spaces(c);
+
+    if (isdigit((unsigned char)*c->p) || *c->p == '.') {
+        char *end;
+        float v = strtof(c->p, &end);
+
+        c->p = end;
+        return emit(c, OP_PUSH, &v, sizeof(v), 1);
+    }
+
+    for (uint8_t v = 0; v < VAR_COUNT; v++) {
+        if (match_word(c, var_names[v])) {
+            return emit(c, OP_LOAD, &v, 1, 1);
+        }
+    }
+
+    if (match(c, "(")) {
+        if (++c->nesting > MAX_NESTING) {
+            return fail(c, "nested too deep");
+        }
+        if (!parse_or(c)) {
+            return false;
+        }
+        c->nesting--;
+        return match(c, ")") || fail(c, "')' expected");
+    }
+
+    return fail(c, "value expected");
+}
+
+static bool parse_unary(compiler_t *c)
+{
+    if (match_minus(c)) {
+        if (++c->nesting > MAX_NESTING) {
+            return fail(c, "nested too deep");
+        }
+        bool ok = parse_unary(c) && emit(c, OP_NEG, NULL, 0, 0);
+        c->nesting--;
+        return ok;
+    }
+    return parse_primary(c);
+}
+
+static bool parse_term(compiler_t *c)
+{
+    if (!parse_unary(c)) {
+        return false;
+    }
+    while (match(c, "*")) {
+        if (!parse_unary(c) || !emit(c, OP_MUL, NULL, 0, -1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parse_sum(compiler_t *c)
+{
+    if (!parse_term(c)) {
+        return false;
+    }
+    for (;;) {
+        rule_op_t op;
+
+        if (match(c, "+")) {
+            op = OP_ADD;
+        } else if (match_minus(c)) {
+            op = OP_SUB;
+        } else {
+            return true;
+        }
+        if (!parse_term(c) || !emit(c, op, NULL, 0, -1)) {
+            return false;
+        }
+    }
+}
+
+static bool parse_compare(compiler_t *c)
+{
+    /* Two-character operators first */
+    static const struct {
+        const char *tok;
+        rule_op_t op;
+    } ops[] = {
+        { "<=", OP_LE }, { ">=", OP_GE }, { "==", OP_EQ }, { "!=", OP_NE },
+        { "<", OP_LT }, { ">", OP_GT }, { "=", OP_EQ },
+    };
+
+    if (!parse_sum(c)) {
+        return false;
+    }
+    for (size_t i = 0; i < ARRAY_SIZE(ops); i++) {
+        if (match(c, ops[i].tok)) {
+            return parse_sum(c) && emit(c, ops[i].op, NULL, 0, -1);
+        }
+    }
+    return true;
+}
+
+static bool parse_not(compiler_t *c)
+{
+    if (match_word(c, "NOT") || match(c, "!")) {
+        if (++c->nesting > MAX_NESTING) {
+            return fail(c, "nested too deep");
+        }
+        bool ok = parse_not(c) && emit(c, OP_NOT, NULL, 0, 0);
+        c->nesting--;
+        return ok;
+    }
+    return parse_compare(c);
+}
+
+static bool parse_and(compiler_t *c)
+{
+    if (!parse_not(c)) {
+        return false;
+    }
+    while (match_word(c, "AND") || match(c, "&&") || match(c, "&")) {
+        if (!parse_not(c) || !emit(c, OP_AND, NULL, 0, -1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool parse_or(compiler_t *c)
+{
+    if (!parse_and(c)) {
+        return false;
+    }
+    while (match_word(c, "OR") || match(c, "||") || match(c, "|")) {
+        if (!parse_and(c) || !emit(c, OP_OR, NULL, 0, -1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* [IF] <condition> THEN|-> <actuator> ON|OFF [FOR <n>[S|M|H]] */
+static bool compile(compiler_t *c)
+{
+    rule_t *r = c->rule;
+    bool found = false;
+
+    match_word(c, "IF");
+    if (!parse_or(c)) {
+        return false;
+    }
+    if (!match_word(c, "THEN") && !match(c, "->")) {
+        return fail(c, "THEN expected");
+    }
+
+    for (int i = 0; i < ACTUATOR_COUNT && !found; i++) {
+        if (match_word(c, actuator_name((actuator_id_t)i))) {
+            r->actuator = (uint8_t)i;
+            found = true;
+        }
+    }
+    if (!found) {
+        return fail(c, "FAN, PUMP or LIGHT expected");
+    }
+
+    if (match_word(c, "ON")) {
+        r->on = true;
+    } else if (!match_word(c, "OFF")) {
+        return fail(c, "ON or OFF expected");
+    }
+
+    r->hold_s = 0;
+    if (match_word(c, "FOR")) {
+        char *end;
+        float t;
+
+        skip_spaces(c);
+        t = strtof(c->p, &end);
+        /* strtof takes NAN and INF too; neither converts to seconds */
+        if (end == c->p || !isfinite(t) || t <= 0.0f) {
+            return fail(c, "duration expected");
+        }
+        c->p = end;
+        if (match_word(c, "M")) {
+            t *= 60.0f;
+        } else if (match_word(c, "H")) {
+            t *= 3600.0f;
+        } else {
+            match_word(c, "S");
+        }
+        if (t < 1.0f || t > UINT16_MAX) {
+            return fail(c, "duration out of range");
+        }
+        r->hold_s = (uint16_t)t;
+    }
+
+    skip_spaces(c);
+    if (*c->p != '\0') {
+        return fail(c, "unexpected text at end");
+    }
+    return emit(c, OP_END, NULL, 0, 0);
+}
+
+/* Compiles 'text' into 'r' (fresh); returns NULL or an error message */
+static const char *compile_rule(const char *text, rule_t *r)
+{
+    compiler_t c = { .p = text, .rule = r };
+
+    memset(r, 0, sizeof(*r));
+    if (strlen(text) >= RULE_TEXT_MAX) {
+        return "rule too long";
+    }
+    strcpy(r->text, text);
+
+    if (!compile(&c)) {
+        return c.err;
+    }
+    return NULL;
+}
+
+/* ---- Evaluation ---- */
+
+/* Runs one rule's code; false if it ran out of budget. The compiler
+ * guarantees the stack bounds, so they are not checked here. */
+static bool run(const rule_t *r, const float vars[VAR_COUNT], bool *result)
+{
+    float stack[RULE_STACK_DEPTH];
+    const uint8_t *pc = r->code;
+    int sp = 0;
+
+    for (int budget = RULE_BUDGET; budget > 0; budget--) {
+        rule_op_t op = (rule_op_t)*pc++;
+        float a, b;
+
+        switch (op) {
+        case OP_END:
+            *result = (stack[0] != 0.0f);
+            return true;
+        case OP_PUSH:
+            memcpy(&stack[sp++], pc, sizeof(float));
+            pc += sizeof(float);
+            continue;
+        case OP_LOAD:
+            stack[sp++] = vars[*pc++];
+            continue;
+        case OP_NEG:
+            stack[sp - 1] = -stack[sp - 1];
+            continue;
+        case OP_NOT:
+            stack[sp - 1] = (stack[sp - 1] == 0.0f) ? 1.0f : 0.0f;
+            continue;
+        default:
+            break;
+        }
+
+        /* Binary operators */
+        b = stack[--sp];
+        a = stack[sp - 1];
+        switch (op) {
+        case OP_ADD: a = a + b; break;
+        case OP_SUB: a = a - b; break;
+        case OP_MUL: a = a * b; break;
+        case OP_LT:  a = (a < b); break;
+        case OP_GT:  a = (a > b); break;
+        case OP_LE:  a = (a <= b); break;
+        case OP_GE:  a = (a >= b); break;
+        case OP_EQ:  a = (a == b); break;
+        case OP_NE:  a = (a != b); break;
+        case OP_AND: a = (a != 0.0f && b != 0.0f); break;
+        case OP_OR:  a = (a != 0.0f || b != 0.0f); break;
+        default:
+            return false;
+        }
+        stack[sp - 1] = a;
+    }
+    return false;
+}
+
+void rule_engine_eval(const env_state_t *st, int64_t now, rule_result_t *out)
+{
+    const float vars[VAR_COUNT] = {
+        [VAR_TEMP] = st->measurements.temperature,
+        [VAR_HUM]  = st->measurements.humidity,
+        [VAR_LUX]  = st->measurements.light,
+        [VAR_TSP]  = st->setpoints.target_temperature,
+        [VAR_HSP]  = st->setpoints.target_humidity,
+        [VAR_LSP]  = st->setpoints.target_light,
+    };
+
+    out->mask = 0;
+    out->on = 0;
+    out->wait_ms = -1;
+
+    k_mutex_lock(&rule_lock, K_FOREVER);
+
+    for (int i = 0; i < rule_count; i++) {
+        rule_t *r = &rules[i];
+        bool cond = false;
+        uint32_t start = k_cycle_get_32();
+
+        if (!run(r, vars, &cond)) {
+            cond = false;
+        }
+
+        uint32_t ns = (uint32_t)k_cyc_to_ns_floor64(k_cycle_get_32() - start);
+        r->evals++;
+        r->eval_sum_ns += ns;
+        r->eval_max_ns = MAX(r->eval_max_ns, ns);
+
+        /* A timed rule starts its hold on the rising edge only */
+        if (cond && !r->was_true) {
+            r->fired++;
+            r->hold_until_ms = now + (int64_t)r->hold_s * 1000;
+        }
+        r->was_true = cond;
+
+        if (r->hold_s > 0) {
+            r->active = (now < r->hold_until_ms);
+            if (r->active && (out->wait_ms < 0 || r->hold_until_ms - now < out->wait_ms)) {
+                out->wait_ms = r->hold_until_ms - now;
+            }
+        } else {
+            r->active = cond;
+        }
+
+        if (r->active && (out->mask & BIT(r->actuator)) == 0) {
+            out->mask |= BIT(r->actuator);
+            if (r->on) {
+                out->on |= BIT(r->actuator);
+            }
+        }
+    }
+
+    k_mutex_unlock(&rule_lock);
+}
+
+/* ---- Table and persistence ---- */
+
+#ifdef CONFIG_SETTINGS
+/* "rules/src" holds the source texts; they are recompiled on load */
+static int rules_settings_set(const char *name, size_t len,
+                              settings_read_cb read_cb, void *cb_arg)
+{
+    static char src[RULE_MAX][RULE_TEXT_MAX];
+    const char *next;
+    int rc, n = 0;
+
+    if (!settings_name_steq(name, "src", &next) || next) {
+        return -ENOENT;
+    }
+    if (len > sizeof(src) || len % RULE_TEXT_MAX != 0) {
+        return -EINVAL;
+    }
+    rc = read_cb(cb_arg, src, len);
+    if (rc < 0) {
+        return rc;
+    }
+
+    k_mutex_lock(&rule_lock, K_FOREVER);
+    rule_count = 0;
+    for (size_t i = 0; i < len / RULE_TEXT_MAX; i++) {
+        src[i][RULE_TEXT_MAX - 1] = '\0';
+        if (compile_rule(src[i], &rules[rule_count]) == NULL) {
+            rule_count++;
+        }
+    }
+    n = rule_count;
+    k_mutex_unlock(&rule_lock);
+
+    printk("Loaded %d rule(s)\n", n);
+    return 0;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(rules, "rules", NULL, rules_settings_set, NULL, NULL);
+#endif
+
+/* Flash writes happen on the system work queue, outside the lock */
+static void save_work_handler(struct k_work *work)
+{
+#ifdef CONFIG_SETTINGS
+    static char src[RULE_MAX][RULE_TEXT_MAX];
+    size_t len;
+    int rc;
+
+    k_mutex_lock(&rule_lock, K_FOREVER);
+    for (int i = 0; i < rule_count; i++) {
+        memcpy(src[i], rules[i].text, RULE_TEXT_MAX);
+    }
+    len = rule_count * RULE_TEXT_MAX;
+    k_mutex_unlock(&rule_lock);
+
+    rc = (len > 0) ? settings_save_one("rules/src", src, len)
+                   : settings_delete("rules/src");
+    if (rc != 0) {
+        printk("Saving rules failed: %d\n", rc);
+    }
+#endif
+}
+
+static K_WORK_DEFINE(save_work, save_work_handler);
+
+int rule_engine_add(const char *text, const char **err)
+{
+    static rule_t fresh;
+    int index;
+
+    k_mutex_lock(&rule_lock, K_FOREVER);
+
+    if (rule_count == RULE_MAX) {
+        k_mutex_unlock(&rule_lock);
+        *err = "too many rules";
+        return -ENOSPC;
+    }
+
+    /* Compiled aside, so a failed rule never reaches the table */
+    *err = compile_rule(text, &fresh);
+    if (*err) {
+        k_mutex_unlock(&rule_lock);
+        return -EINVAL;
+    }
+    index = rule_count;
+    rules[rule_count++] = fresh;
+
+    k_mutex_unlock(&rule_lock);
+
+    k_work_submit(&save_work);
+    return index;
+}
+
+int rule_engine_remove(int index)
+{
+    k_mutex_lock(&rule_lock, K_FOREVER);
+    if (index < 0 || index >= rule_count) {
+        k_mutex_unlock(&rule_lock);
+        return -ENOENT;
+    }
+    memmove(&rules[index], &rules[index + 1], (rule_count - index - 1) * sizeof(rules[0]));
+    rule_count--;
+    k_mutex_unlock(&rule_lock);
+
+    k_work_submit(&save_work);
+    return 0;
+}
+
+void rule_engine_clear(void)
+{
+    k_mutex_lock(&rule_lock, K_FOREVER);
+    rule_count = 0;
+    k_mutex_unlock(&rule_lock);
+
+    k_work_submit(&save_work);
+}
+
+int rule_engine_count(void)
+{
+    return rule_count;
+}
+
+int rule_engine_get(int index, rule_info_t *out)
+{
+    int ret = -ENOENT;
+
+    k_mutex_lock(&rule_lock, K_FOREVER);
+    if (index >= 0 && index < rule_count) {
+        const rule_t *r = &rules[index];
+
+        memcpy(out->text, r->text, sizeof(out->text));
+        out->actuator = r->actuator;
+        out->on = r->on;
+        out->active = r->active;
+        out->hold_s = r->hold_s;
+        out->code_len = r->code_len;
+        out->fired = r->fired;
+        out->eval_avg_ns = r->evals ? (uint32_t)(r->eval_sum_ns / r->evals) : 0;
+        out->eval_max_ns = r->eval_max_ns;
+        ret = 0;
+    }
+    k_mutex_unlock(&rule_lock);
+    return ret;
+}
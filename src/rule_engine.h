@@ -0,0 +1,68 @@
+/**
+ * @file rule_engine.h
+ * @brief User automation rules compiled to a small stack bytecode
+ *
+ * A rule is a condition on the measurements and setpoints, and an
+ * actuator state to force while it holds:
+ *
+ *   IF TEMP>30 AND HUM<40 THEN PUMP ON FOR 5M
+ *   HUM>TSP+20 | LUX<100 -> LIGHT OFF
+ *
+ * Operands are TEMP, HUM, LUX, the setpoints TSP, HSP, LSP and numbers;
+ * operators are + - *, comparisons < > <= >= == !=, AND/&, OR/|, NOT/!
+ * and parentheses. With FOR n[S|M] the actuator is held for that time
+ * from the moment the condition becomes true, otherwise for as long as
+ * it is true. The first rule forcing an actuator wins.
+ *
+ * Rules are compiled on the device into fixed-size slots (no heap).
+ * Evaluation is straight-line code on a small float stack, bounded by
+ * RULE_BUDGET instructions per rule. Sources are stored with the
+ * settings subsystem ("rules/src") and recompiled at boot.
+ */
+
+#ifndef RULE_ENGINE_H
+#define RULE_ENGINE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "env_controller.h"
+
+#define RULE_MAX            8
+#define RULE_TEXT_MAX       48      /* Source text, NUL included */
+#define RULE_CODE_MAX       48      /* Bytecode bytes per rule */
+#define RULE_STACK_DEPTH    8
+#define RULE_BUDGET         64      /* Instructions per evaluation */
+
+typedef struct {
+    char text[RULE_TEXT_MAX];
+    uint8_t actuator;               /* actuator_id_t */
+    bool on;
+    bool active;                    /* Forcing its actuator right now */
+    uint16_t hold_s;                /* 0: while the condition holds */
+    uint8_t code_len;
+    uint32_t fired;                 /* Times the condition became true */
+    uint32_t eval_avg_ns;           /* Evaluation time */
+    uint32_t eval_max_ns;
+} rule_info_t;
+
+/* Actuators forced by the rules in one evaluation */
+typedef struct {
+    uint32_t mask;                  /* Actuators a rule decides */
+    uint32_t on;                    /* Their state */
+    int64_t wait_ms;                /* Next hold expiry, -1 if none */
+} rule_result_t;
+
+/* Compiles and appends a rule; returns its index, or -EINVAL with
+ * 'err' pointing to a short message, -ENOSPC when the table is full */
+int rule_engine_add(const char *text, const char **err);
+int rule_engine_remove(int index);
+void rule_engine_clear(void);
+int rule_engine_count(void);
+
+/* Evaluates all rules at 'now' (call once per control cycle) */
+void rule_engine_eval(const env_state_t *st, int64_t now, rule_result_t *out);
+
+/* 0, or -ENOENT past the last rule */
+int rule_engine_get(int index, rule_info_t *out);
+
+#endif /* RULE_ENGINE_H */
@@ -0,0 +1,269 @@
+/**
+ * @file schedule.c
+ * @brief Time-of-day setpoint schedule
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/settings/settings.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+#include "schedule.h"
+#include "adjust_manager.h"
+
+#define DAY_MS      ((int64_t)SCHEDULE_DAY_MIN * 60000)
+
+K_MUTEX_DEFINE(sched_lock);
+
+/* Table and clock (under sched_lock), entries sorted by start_min */
+static schedule_entry_t entries[SCHEDULE_MAX_ENTRIES];
+static int entry_count;
+static bool enabled = true;
+static int64_t clock_offset_ms;
+static bool clock_set;
+static int active = -1;
+static bool reapply;                    /* Table or clock changed */
+static uint32_t transitions;
+
+static void schedule_work_handler(struct k_work *work);
+static K_WORK_DEFINE(sched_work, schedule_work_handler);
+
+/* Runs at the next transition only; the work does the rest */
+static void sched_timer_expiry(struct k_timer *timer)
+{
+    k_work_submit(&sched_work);
+}
+
+K_TIMER_DEFINE(sched_timer, sched_timer_expiry, NULL);
+
+static int64_t time_of_day_ms(void)
+{
+    return (k_uptime_get() + clock_offset_ms) % DAY_MS;
+}
+
+/* Last entry started at or before 'now_min', else yesterday's last one */
+static int find_active(uint16_t now_min)
+{
+    int found = entry_count - 1;
+
+    for (int i = 0; i < entry_count && entries[i].start_min <= now_min; i++) {
+        found = i;
+    }
+    return found;
+}
+
+/* Re-evaluates the table and arms the timer for the following entry */
+static void schedule_work_handler(struct k_work *work)
+{
+    env_setpoints_t sp;
+    bool apply = false;
+    int idx = -1;
+    uint16_t start = 0;
+
+    k_mutex_lock(&sched_lock, K_FOREVER);
+    k_timer_stop(&sched_timer);
+
+    if (enabled && entry_count > 0) {
+        int64_t tod = time_of_day_ms();
+        int prev = active;
+
+        active = find_active((uint16_t)(tod / 60000));
+
+        int next = (active + 1) % entry_count;
+        int64_t delay = entries[next].start_min * 60000 - tod;
+        if (delay <= 0) {
+            delay += DAY_MS;
+        }
+        k_timer_start(&sched_timer, K_MSEC(delay), K_NO_WAIT);
+
+        if (active != prev || reapply) {
+            sp = entries[active].setpoints;
+            idx = active;
+            start = entries[active].start_min;
+            apply = true;
+            transitions++;
+        }
+    } else {
+        active = -1;
+    }
+    reapply = false;
+
+    k_mutex_unlock(&sched_lock);
+
+    if (apply) {
+        printk("Schedule: entry %d (%02u:%02u)\n", idx, start / 60, start % 60);
+        adjust_manager_apply_new_setpoints(&sp, k_cycle_get_32());
+    }
+}
+
+#ifdef CONFIG_SETTINGS
+/* "sched/table" holds the sorted entries, "sched/on" the enable flag */
+static int sched_settings_set(const char *name, size_t len,
+                              settings_read_cb read_cb, void *cb_arg)
+{
+    const char *next;
+    int rc;
+
+    if (settings_name_steq(name, "table", &next) && !next) {
+        schedule_entry_t table[SCHEDULE_MAX_ENTRIES];
+
+        if (len > sizeof(table) || len % sizeof(table[0]) != 0) {
+            return -EINVAL;
+        }
+        rc = read_cb(cb_arg, table, len);
+        if (rc < 0) {
+            return rc;
+        }
+
+        k_mutex_lock(&sched_lock, K_FOREVER);
+        memcpy(entries, table, len);
+        entry_count = (int)(len / sizeof(table[0]));
+        reapply = true;
+        k_mutex_unlock(&sched_lock);
+
+        printk("Loaded schedule: %d entries\n", (int)(len / sizeof(table[0])));
+        return 0;
+    }
+
+    if (settings_name_steq(name, "on", &next) && !next) {
+        uint8_t on;
+
+        if (len != sizeof(on)) {
+            return -EINVAL;
+        }
+        rc = read_cb(cb_arg, &on, sizeof(on));
+        if (rc < 0) {
+            return rc;
+        }
+        enabled = (on != 0);
+        return 0;
+    }
+
+    return -ENOENT;
+}
+
+SETTINGS_STATIC_HANDLER_DEFINE(sched, "sched", NULL, sched_settings_set, NULL, NULL);
+#endif
+
+/* Flash writes happen on the system work queue, outside the lock */
+static void save_work_handler(struct k_work *work)
+{
+#ifdef CONFIG_SETTINGS
+    schedule_entry_t table[SCHEDULE_MAX_ENTRIES];
+    uint8_t on;
+    size_t len;
+    int rc;
+
+    k_mutex_lock(&sched_lock, K_FOREVER);
+    len = entry_count * sizeof(table[0]);
+    memcpy(table, entries, len);
+    on = enabled ? 1 : 0;
+    k_mutex_unlock(&sched_lock);
+
+    /* An empty table is stored as a deleted key */
+    rc = (len > 0) ? settings_save_one("sched/table", table, len)
+                   : settings_delete("sched/table");
+    if (rc == 0) {
+        rc = settings_save_one("sched/on", &on, sizeof(on));
+    }
+    if (rc != 0) {
+        printk("Saving schedule failed: %d\n", rc);
+    }
+#endif
+}
+
+static K_WORK_DEFINE(save_work, save_work_handler);
+
+/* Call with sched_lock held: persist and re-evaluate */
+static void table_changed(void)
+{
+    reapply = true;
+    k_work_submit(&save_work);
+    k_work_submit(&sched_work);
+}
+
+void schedule_start(void)
+{
+    k_work_submit(&sched_work);
+}
+
+int schedule_add(const schedule_entry_t *entry)
+{
+    int pos;
+
+    if (entry->start_min >= SCHEDULE_DAY_MIN || !adjust_manager_validate(&entry->setpoints)) {
+        return -EINVAL;
+    }
+
+    k_mutex_lock(&sched_lock, K_FOREVER);
+
+    for (pos = 0; pos < entry_count && entries[pos].start_min < entry->start_min; pos++) {
+    }
+
+    if (pos == entry_count || entries[pos].start_min != entry->start_min) {
+        if (entry_count == SCHEDULE_MAX_ENTRIES) {
+            k_mutex_unlock(&sched_lock);
+            return -ENOSPC;
+        }
+        memmove(&entries[pos + 1], &entries[pos], (entry_count - pos) * sizeof(entries[0]));
+        entry_count++;
+    }
+    entries[pos] = *entry;
+    table_changed();
+
+    k_mutex_unlock(&sched_lock);
+    return 0;
+}
+
+void schedule_clear(void)
+{
+    k_mutex_lock(&sched_lock, K_FOREVER);
+    entry_count = 0;
+    active = -1;
+    table_changed();
+    k_mutex_unlock(&sched_lock);
+}
+
+void schedule_enable(bool enable)
+{
+    k_mutex_lock(&sched_lock, K_FOREVER);
+    enabled = enable;
+    table_changed();
+    k_mutex_unlock(&sched_lock);
+}
+
+void schedule_set_clock(uint16_t minute_of_day)
+{
+    k_mutex_lock(&sched_lock, K_FOREVER);
+    clock_offset_ms = ((int64_t)(minute_of_day % SCHEDULE_DAY_MIN) * 60000 -
+                       k_uptime_get() % DAY_MS + DAY_MS) % DAY_MS;
+    clock_set = true;
+    reapply = true;
+    k_work_submit(&sched_work);
+    k_mutex_unlock(&sched_lock);
+}
+
+int schedule_get_entry(int index, schedule_entry_t *out)
+{
+    int ret = -ENOENT;
+
+    k_mutex_lock(&sched_lock, K_FOREVER);
+    if (index >= 0 && index < entry_count) {
+        *out = entries[index];
+        ret = 0;
+    }
+    k_mutex_unlock(&sched_lock);
+    return ret;
+}
+
+void schedule_get_info(schedule_info_t *out)
+{
+    k_mutex_lock(&sched_lock, K_FOREVER);
+    out->enabled = enabled;
+    out->clock_set = clock_set;
+    out->count = entry_count;
+    out->active = active;
+    out->now_min = (uint16_t)(time_of_day_ms() / 60000);
+    out->next_min = (active >= 0 && entry_count > 0) ? entries[(active + 1) % entry_count].start_min : 0;
+    out->transitions = transitions;
+    k_mutex_unlock(&sched_lock);
+}
@@ -0,0 +1,57 @@
+/**
+ * @file schedule.h
+ * @brief Time-of-day setpoint schedule
+ *
+ * A daily profile of up to SCHEDULE_MAX_ENTRIES setpoint sets, each
+ * taking over at its start minute. Entries are kept sorted, so the
+ * next transition is always the following entry: a one-shot k_timer
+ * is armed for it and nothing runs in between. Changes are applied
+ * through adjust_manager_apply_new_setpoints() from the system work
+ * queue. The table is stored with the settings subsystem ("sched/").
+ *
+ * There is no RTC: the time of day is the uptime plus an offset set
+ * with schedule_set_clock(), and reads 00:00 at boot until then.
+ */
+
+#ifndef SCHEDULE_H
+#define SCHEDULE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "env_controller.h"
+
+#define SCHEDULE_MAX_ENTRIES    8
+#define SCHEDULE_DAY_MIN        (24 * 60)
+
+typedef struct {
+    uint16_t start_min;             /* Minute of the day, 0..1439 */
+    env_setpoints_t setpoints;
+} schedule_entry_t;
+
+typedef struct {
+    bool enabled;
+    bool clock_set;
+    int count;
+    int active;                     /* Entry in force, -1 if none */
+    uint16_t now_min;               /* Current time of day */
+    uint16_t next_min;              /* Start of the next entry */
+    uint32_t transitions;
+} schedule_info_t;
+
+/* Arms the timer for the stored table (call after settings_load) */
+void schedule_start(void);
+
+/* Adds an entry, replacing one with the same start minute.
+ * -EINVAL for out of range values, -ENOSPC when the table is full. */
+int schedule_add(const schedule_entry_t *entry);
+void schedule_clear(void);
+void schedule_enable(bool enable);
+
+/* Sets the time of day; the active entry is re-evaluated */
+void schedule_set_clock(uint16_t minute_of_day);
+
+/* 0, or -ENOENT past the last entry */
+int schedule_get_entry(int index, schedule_entry_t *out);
+void schedule_get_info(schedule_info_t *out);
+
+#endif /* SCHEDULE_H */
@@ -14,20 +14,106 @@
 
 LOG_MODULE_REGISTER(sensor_manager, LOG_LEVEL_DBG);
 
-/* Device tree labels - MUST MATCH your .dts files */
-#define LM35_NODE        DT_ALIAS(lm35)
-#define BH1750_NODE      DT_ALIAS(bh1750)
-#define DHT11_NODE       DT_ALIAS(dht11)
+/* Channel table generated from greenhouse,channel nodes */
+#define SENSOR_DEV_ENTRY(node, prop, idx) \
+    DEVICE_DT_GET_OR_NULL(DT_PHANDLE_BY_IDX(node, prop, idx)),
 
-/* Device pointers */
-static const struct device *const lm35_dev = DEVICE_DT_GET_OR_NULL(LM35_NODE);
-static const struct device *const bh1750_dev = DEVICE_DT_GET_OR_NULL(BH1750_NODE);
-static const struct device *const dht11_dev = DEVICE_DT_GET_OR_NULL(DHT11_NODE);
+#define SENSOR_LIST_NAME(node) UTIL_CAT(channel_sensors_, DT_DEP_ORD(node))
+
+#define SENSOR_LIST_DEFINE(node) \
+    static const struct device *const SENSOR_LIST_NAME(node)[] = { \
+        DT_FOREACH_PROP_ELEM(node, sensors, SENSOR_DEV_ENTRY) \
+    };
+
+#define CHANNEL_INFO_ENTRY(node) \
+    [UTIL_CAT(SENSOR_CH_, DT_STRING_UPPER_TOKEN(node, channel_id))] = { \
+        .name = DT_PROP(node, short_name), \
+        .unit = DT_PROP(node, unit), \
+        .chan = UTIL_CAT(SENSOR_CHAN_, DT_STRING_UPPER_TOKEN(node, sensor_channel)), \
+        .scale_milli = DT_PROP(node, scale_milli), \
+        .offset_milli = DT_PROP(node, offset_milli), \
+        .range_min = DT_PROP(node, range_min), \
+        .range_max = DT_PROP(node, range_max), \
+        .log_scale = DT_PROP(node, log_scale), \
+        .sensor_count = DT_PROP_LEN(node, sensors), \
+        .sensors = SENSOR_LIST_NAME(node), \
+    },
+
+DT_FOREACH_STATUS_OKAY(SENSOR_CHANNEL_COMPAT, SENSOR_LIST_DEFINE)
+
+static const sensor_channel_info_t channels[SENSOR_CH_COUNT] = {
+    DT_FOREACH_STATUS_OKAY(SENSOR_CHANNEL_COMPAT, CHANNEL_INFO_ENTRY)
+};
+
+/* Runtime device registry: each distinct device once, shared by channels */
+static const struct device *devices[SENSOR_DEV_MAX];
+static int device_count;
+static sensor_dev_t channel_refs[SENSOR_DEV_MAX];   /* Device index per sensors[] slot */
+static uint8_t channel_ref_base[SENSOR_CH_COUNT];   /* First slot of each channel */
 
 /* Error tracking */
 static char error_msg[64] = {0};
 static bool sensors_ready = false;
 
+/* Health tracking */
+static sensor_health_t health[SENSOR_DEV_MAX];
+static uint32_t fetch_cycle;                        /* Bumped per read cycle */
+static uint32_t fetch_cycle_of[SENSOR_DEV_MAX];     /* Cycle of last fetch */
+static int fetch_result[SENSOR_DEV_MAX];            /* Result of that fetch */
+
+/* Sample age tracking */
+static uint32_t last_valid_ms[SENSOR_CH_COUNT];
+static bool ever_valid[SENSOR_CH_COUNT];
+
+/* Wrap-safe "now is at or after deadline" */
+static bool time_reached(uint32_t now, uint32_t deadline)
+{
+    return (int32_t)(now - deadline) >= 0;
+}
+
+const char* sensor_device_name(sensor_dev_t dev)
+{
+    if (dev >= device_count) {
+        return "?";
+    }
+    return devices[dev] ? devices[dev]->name : "(none)";
+}
+
+/* Registers a device once and returns its index */
+static sensor_dev_t register_device(const struct device *dev)
+{
+    for (int i = 0; i < device_count; i++) {
+        if (devices[i] == dev) {
+            return (sensor_dev_t)i;
+        }
+    }
+
+    devices[device_count] = dev;
+    if (!dev || !device_is_ready(dev)) {
+        health[device_count].state = SENSOR_HEALTH_ABSENT;
+    }
+    return (sensor_dev_t)device_count++;
+}
+
+/* Builds the device registry and resets health records */
+static void registry_init(void)
+{
+    int slot = 0;
+
+    device_count = 0;
+    memset(health, 0, sizeof(health));
+    memset(fetch_cycle_of, 0, sizeof(fetch_cycle_of));
+    memset(last_valid_ms, 0, sizeof(last_valid_ms));
+    memset(ever_valid, 0, sizeof(ever_valid));
+
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        channel_ref_base[ch] = (uint8_t)slot;
+        for (int i = 0; i < channels[ch].sensor_count; i++) {
+            channel_refs[slot++] = register_device(channels[ch].sensors[i]);
+        }
+    }
+}
+
 /**
  * @brief Initialize all sensors
  * @return 0 on success, negative error code on failure
@@ -35,160 +121,163 @@ static bool sensors_ready = false;
 int sensor_manager_init(void)
 {
     int ret = 0;
-    
+
     LOG_INF("Initializing sensor manager...");
-    
-    /* Check if devices are ready */
-    if (lm35_dev && !device_is_ready(lm35_dev)) {
-        LOG_ERR("LM35 device not ready");
-        snprintf(error_msg, sizeof(error_msg), "LM35 not ready");
-        ret = -ENODEV;
-    }
-    
-    if (bh1750_dev && !device_is_ready(bh1750_dev)) {
-        LOG_ERR("BH1750 device not ready");
-        snprintf(error_msg, sizeof(error_msg), "BH1750 not ready");
-        ret = -ENODEV;
-    }
-    
-    if (dht11_dev && !device_is_ready(dht11_dev)) {
-        LOG_ERR("DHT11 device not ready");
-        snprintf(error_msg, sizeof(error_msg), "DHT11 not ready");
-        ret = -ENODEV;
-    }
-    
-    /* Check if at least one sensor is available */
-    if (!lm35_dev && !dht11_dev) {
-        LOG_ERR("No temperature sensor available");
-        snprintf(error_msg, sizeof(error_msg), "No temp sensor");
-        ret = -ENODEV;
+
+    registry_init();
+
+    for (int i = 0; i < device_count; i++) {
+        if (health[i].state == SENSOR_HEALTH_ABSENT) {
+            LOG_ERR("%s device not ready", sensor_device_name((sensor_dev_t)i));
+        }
     }
-    
-    if (!bh1750_dev) {
-        LOG_ERR("No light sensor available");
-        snprintf(error_msg, sizeof(error_msg), "No light sensor");
-        ret = -ENODEV;
+
+    /* Every channel needs at least one usable device */
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        bool usable = false;
+
+        for (int i = 0; i < channels[ch].sensor_count; i++) {
+            if (health[channel_refs[channel_ref_base[ch] + i]].state != SENSOR_HEALTH_ABSENT) {
+                usable = true;
+            }
+        }
+
+        if (!usable) {
+            LOG_ERR("No %s sensor available", channels[ch].name);
+            snprintf(error_msg, sizeof(error_msg), "No %s sensor", channels[ch].name);
+            ret = -ENODEV;
+        }
     }
-    
+
     if (ret == 0) {
         sensors_ready = true;
-        LOG_INF("Sensor manager initialized successfully");
-        LOG_INF("Available sensors: %s%s%s",
-                lm35_dev ? "LM35 " : "",
-                bh1750_dev ? "BH1750 " : "",
-                dht11_dev ? "DHT11" : "");
+        LOG_INF("Sensor manager initialized: %d channels, %d devices",
+                SENSOR_CH_COUNT, device_count);
     }
-    
+
     return ret;
 }
 
-/**
- * @brief Read temperature from available sensor
- * @param temp Pointer to store temperature value
- * @return 0 on success, negative error code on failure
- */
-static int read_temperature(float *temp)
+static void health_record_success(sensor_dev_t id, uint32_t now)
 {
-    struct sensor_value val;
-    int ret;
-    
-    /* Prefer DHT11 if available (has humidity too) */
-    if (dht11_dev && device_is_ready(dht11_dev)) {
-        ret = sensor_sample_fetch(dht11_dev);
-        if (ret < 0) {
-            LOG_ERR("Failed to fetch DHT11 sample: %d", ret);
-            return ret;
-        }
-        
-        ret = sensor_channel_get(dht11_dev, SENSOR_CHAN_AMBIENT_TEMP, &val);
-        if (ret < 0) {
-            LOG_ERR("Failed to get DHT11 temperature: %d", ret);
-            return ret;
-        }
-        
-        *temp = sensor_value_to_float(&val);
-        return 0;
+    sensor_health_t *h = &health[id];
+
+    if (h->state != SENSOR_HEALTH_OK) {
+        LOG_INF("%s recovered after %u failures", sensor_device_name(id),
+                h->consecutive_failures);
     }
-    
-    /* Fall back to LM35 */
-    if (lm35_dev && device_is_ready(lm35_dev)) {
-        ret = sensor_sample_fetch(lm35_dev);
-        if (ret < 0) {
-            LOG_ERR("Failed to fetch LM35 sample: %d", ret);
-            return ret;
-        }
-        
-        ret = sensor_channel_get(lm35_dev, SENSOR_CHAN_AMBIENT_TEMP, &val);
-        if (ret < 0) {
-            LOG_ERR("Failed to get LM35 temperature: %d", ret);
-            return ret;
+    h->state = SENSOR_HEALTH_OK;
+    h->consecutive_failures = 0;
+    h->last_success_ms = now;
+    h->last_error = 0;
+}
+
+static void health_record_failure(sensor_dev_t id, uint32_t now, int err)
+{
+    sensor_health_t *h = &health[id];
+
+    h->consecutive_failures++;
+    h->total_failures++;
+    h->last_error = err;
+    snprintf(error_msg, sizeof(error_msg), "%s fetch failed (%d)", sensor_device_name(id), err);
+
+    if (h->consecutive_failures >= SENSOR_BREAKER_THRESHOLD) {
+        if (h->state != SENSOR_HEALTH_OPEN) {
+            LOG_ERR("%s failed %u times, polling suspended", sensor_device_name(id),
+                    h->consecutive_failures);
         }
-        
-        *temp = sensor_value_to_float(&val);
-        return 0;
+        h->state = SENSOR_HEALTH_OPEN;
+        h->next_attempt_ms = now + SENSOR_PROBE_INTERVAL_MS;
+        return;
+    }
+
+    /* 1 s, 2 s, 4 s ... capped at SENSOR_BACKOFF_MAX_MS */
+    uint32_t backoff = SENSOR_BACKOFF_BASE_MS << (h->consecutive_failures - 1);
+    if (backoff > SENSOR_BACKOFF_MAX_MS) {
+        backoff = SENSOR_BACKOFF_MAX_MS;
+    }
+
+    if (h->state == SENSOR_HEALTH_OK) {
+        LOG_WRN("%s fetch failed: %d, backing off", sensor_device_name(id), err);
     }
-    
-    return -ENODEV;
+    h->state = SENSOR_HEALTH_BACKOFF;
+    h->next_attempt_ms = now + backoff;
 }
 
 /**
- * @brief Read light level from BH1750
- * @param light Pointer to store light value in lux
- * @return 0 on success, negative error code on failure
+ * @brief Fetch a device sample through its health gate
+ *
+ * Each device is fetched at most once per read cycle (a DHT11 serves
+ * both temperature and humidity). Failing devices are skipped until
+ * their backoff or probe deadline expires.
+ *
+ * @return 0 on success, -EAGAIN if suppressed, negative error otherwise
  */
-static int read_light(float *light)
+static int fetch_device(sensor_dev_t id)
 {
-    struct sensor_value val;
+    sensor_health_t *h = &health[id];
+    uint32_t now = k_uptime_get_32();
     int ret;
-    
-    if (!bh1750_dev || !device_is_ready(bh1750_dev)) {
+
+    if (h->state == SENSOR_HEALTH_ABSENT) {
         return -ENODEV;
     }
-    
-    ret = sensor_sample_fetch(bh1750_dev);
-    if (ret < 0) {
-        LOG_ERR("Failed to fetch BH1750 sample: %d", ret);
-        return ret;
+
+    if (fetch_cycle_of[id] == fetch_cycle) {
+        return fetch_result[id];
     }
-    
-    ret = sensor_channel_get(bh1750_dev, SENSOR_CHAN_LIGHT, &val);
+    fetch_cycle_of[id] = fetch_cycle;
+
+    if (h->state != SENSOR_HEALTH_OK && !time_reached(now, h->next_attempt_ms)) {
+        h->total_skipped++;
+        fetch_result[id] = -EAGAIN;
+        return -EAGAIN;
+    }
+
+    ret = sensor_sample_fetch(devices[id]);
     if (ret < 0) {
-        LOG_ERR("Failed to get BH1750 light: %d", ret);
-        return ret;
+        health_record_failure(id, now, ret);
+    } else {
+        health_record_success(id, now);
     }
-    
-    *light = sensor_value_to_float(&val);
-    return 0;
+
+    fetch_result[id] = ret;
+    return ret;
 }
 
 /**
- * @brief Read humidity from DHT11
- * @param humidity Pointer to store humidity value
- * @return 0 on success, negative error code on failure
+ * @brief Read one channel, trying its devices in fallback order
+ * @param ch Channel to read
+ * @param out Scaled value in the channel's unit
+ * @return 0 on success, error of the last device tried otherwise
  */
-static int read_humidity(float *humidity)
+static int read_channel(sensor_ch_t ch, float *out)
 {
+    const sensor_channel_info_t *info = &channels[ch];
     struct sensor_value val;
-    int ret;
-    
-    if (!dht11_dev || !device_is_ready(dht11_dev)) {
-        return -ENODEV;
-    }
-    
-    ret = sensor_sample_fetch(dht11_dev);
-    if (ret < 0) {
-        LOG_ERR("Failed to fetch DHT11 sample: %d", ret);
-        return ret;
-    }
-    
-    ret = sensor_channel_get(dht11_dev, SENSOR_CHAN_HUMIDITY, &val);
-    if (ret < 0) {
-        LOG_ERR("Failed to get DHT11 humidity: %d", ret);
-        return ret;
+    int ret = -ENODEV;
+
+    for (int i = 0; i < info->sensor_count; i++) {
+        sensor_dev_t id = channel_refs[channel_ref_base[ch] + i];
+
+        ret = fetch_device(id);
+        if (ret < 0) {
+            continue;
+        }
+
+        ret = sensor_channel_get(devices[id], info->chan, &val);
+        if (ret < 0) {
+            LOG_ERR("Failed to get %s from %s: %d", info->name,
+                    sensor_device_name(id), ret);
+            continue;
+        }
+
+        *out = sensor_value_to_float(&val) * (float)info->scale_milli / 1000.0f +
+               (float)info->offset_milli / 1000.0f;
+        return 0;
     }
-    
-    *humidity = sensor_value_to_float(&val);
-    return 0;
+
+    return ret;
 }
 
 /**
@@ -199,67 +288,109 @@ static int read_humidity(float *humidity)
 int sensor_manager_read_all(sensor_data_t *data)
 {
     int ret = 0;
-    int temp_ret, light_ret, humid_ret;
-    
+    uint32_t now;
+
     if (!data || !sensors_ready) {
         return -EINVAL;
     }
-    
-    /* Clear data structure */
+
+    /* Clear data structure and start a new fetch cycle */
     memset(data, 0, sizeof(sensor_data_t));
-    
-    /* Read temperature */
-    temp_ret = read_temperature(&data->temperature);
-    if (temp_ret == 0) {
-        data->temperature_valid = true;
-    } else {
-        data->temperature = NAN;
-        data->temperature_valid = false;
-        ret = temp_ret;
-        LOG_WRN("Failed to read temperature: %d", temp_ret);
+    fetch_cycle++;
+    now = k_uptime_get_32();
+
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        int ch_ret = read_channel((sensor_ch_t)ch, &data->value[ch]);
+
+        if (ch_ret == 0) {
+            data->valid[ch] = true;
+            last_valid_ms[ch] = now;
+            ever_valid[ch] = true;
+            continue;
+        }
+
+        data->value[ch] = NAN;
+        ret = ch_ret;
+        /* Suppressed reads are expected while backing off, don't warn again */
+        if (ch_ret != -EAGAIN) {
+            LOG_WRN("Failed to read %s: %d", channels[ch].name, ch_ret);
+        }
     }
-    
-    /* Read light */
-    light_ret = read_light(&data->light_level);
-    if (light_ret == 0) {
-        data->light_valid = true;
-    } else {
-        data->light_level = NAN;
-        data->light_valid = false;
-        ret = light_ret;
-        LOG_WRN("Failed to read light: %d", light_ret);
+
+    data->timestamp = now;
+    data->sample_cycles = k_cycle_get_32();
+
+    return ret;
+}
+
+/* Individual channel read (its own fetch cycle) */
+int sensor_manager_read_channel(sensor_ch_t ch, float *value)
+{
+    if (ch >= SENSOR_CH_COUNT || !value || !sensors_ready) {
+        return -EINVAL;
     }
-    
-    /* Read humidity */
-    humid_ret = read_humidity(&data->humidity);
-    if (humid_ret == 0) {
-        data->humidity_valid = true;
-    } else {
-        data->humidity = NAN;
-        data->humidity_valid = false;
-        ret = humid_ret;
-        LOG_WRN("Failed to read humidity: %d", humid_ret);
+
+    fetch_cycle++;
+    return read_channel(ch, value);
+}
+
+/* Channel helpers */
+bool sensor_data_get_channel(const sensor_data_t *data, sensor_ch_t ch, float *value)
+{
+    if (!data || !value || ch >= SENSOR_CH_COUNT) {
+        return false;
     }
-    
-    data->timestamp = k_uptime_get_32();
-    
-    return ret;
+
+    *value = data->value[ch];
+    return data->valid[ch];
 }
 
-/* Individual sensor reading functions */
-int sensor_manager_read_temperature(float *temp)
+const sensor_channel_info_t* sensor_channel_info(sensor_ch_t ch)
 {
-    return read_temperature(temp);
+    return (ch < SENSOR_CH_COUNT) ? &channels[ch] : NULL;
 }
 
-int sensor_manager_read_light(float *light)
+const char* sensor_channel_name(sensor_ch_t ch)
 {
-    return read_light(light);
+    return (ch < SENSOR_CH_COUNT) ? channels[ch].name : "?";
+}
+
+/* Health and staleness */
+int sensor_manager_device_count(void)
+{
+    return device_count;
+}
+
+int sensor_manager_get_health(sensor_dev_t dev, sensor_health_t *out)
+{
+    if (dev >= device_count || !out) {
+        return -EINVAL;
+    }
+    *out = health[dev];
+    return 0;
+}
+
+const char* sensor_health_state_name(sensor_health_state_t state)
+{
+    switch (state) {
+    case SENSOR_HEALTH_OK:      return "OK";
+    case SENSOR_HEALTH_BACKOFF: return "BACKOFF";
+    case SENSOR_HEALTH_OPEN:    return "OPEN";
+    default:                    return "ABSENT";
+    }
+}
+
+uint32_t sensor_manager_channel_age_ms(sensor_ch_t ch)
+{
+    if (ch >= SENSOR_CH_COUNT || !ever_valid[ch]) {
+        return UINT32_MAX;
+    }
+    return k_uptime_get_32() - last_valid_ms[ch];
 }
 
-int sensor_manager_read_humidity(float *humidity)
+bool sensor_manager_is_stale(sensor_ch_t ch)
 {
-    return read_humidity(humidity);
+    return sensor_manager_channel_age_ms(ch) > SENSOR_STALE_MS;
 }
 
 /* Status functions */
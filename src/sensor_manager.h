@@ -1,22 +1,87 @@
 /**
  * @file sensor_manager.h
  * @brief Manager for all environmental sensors
+ *
+ * Channels come from devicetree nodes with compatible "greenhouse,channel"
+ * (see dts/bindings/greenhouse,channel.yaml). Each node generates an
+ * enumerator SENSOR_CH_<CHANNEL-ID>; the controller relies on the
+ * "temperature", "humidity" and "light" channels being present.
  */
 
 #ifndef SENSOR_MANAGER_H
 #define SENSOR_MANAGER_H
 
+#include <zephyr/devicetree.h>
 #include <zephyr/drivers/sensor.h>
+#include <zephyr/sys/util.h>
+
+#define SENSOR_CHANNEL_COMPAT greenhouse_channel
+
+/* Logical measurement channels, one per enabled greenhouse,channel node */
+#define SENSOR_CH_ENUM_ENTRY(node) \
+    UTIL_CAT(SENSOR_CH_, DT_STRING_UPPER_TOKEN(node, channel_id)),
+
+typedef enum {
+    DT_FOREACH_STATUS_OKAY(SENSOR_CHANNEL_COMPAT, SENSOR_CH_ENUM_ENTRY)
+    SENSOR_CH_COUNT
+} sensor_ch_t;
+
+/* Upper bound of distinct sensor devices (sum of all 'sensors' lists) */
+#define SENSOR_REF_COUNT_ENTRY(node) DT_PROP_LEN(node, sensors) +
+#define SENSOR_DEV_MAX \
+    (DT_FOREACH_STATUS_OKAY(SENSOR_CHANNEL_COMPAT, SENSOR_REF_COUNT_ENTRY) 0)
+
+/* Index into the runtime device registry (0 .. sensor_manager_device_count()-1) */
+typedef uint8_t sensor_dev_t;
+
+/* Static description of a channel, generated from devicetree */
+typedef struct {
+    const char *name;           /* Command key, e.g. "TEMP" */
+    const char *unit;           /* Display unit, e.g. "C" */
+    enum sensor_channel chan;   /* Zephyr sensor channel to read */
+    int32_t scale_milli;        /* value = raw * scale / 1000 + offset / 1000 */
+    int32_t offset_milli;
+    int32_t range_min;          /* Expected physical range */
+    int32_t range_max;
+    bool log_scale;             /* Range spans decades (e.g. lux) */
+    uint8_t sensor_count;
+    const struct device *const *sensors;    /* In fallback order */
+} sensor_channel_info_t;
+
+/* Health state of a device (circuit breaker) */
+typedef enum {
+    SENSOR_HEALTH_OK = 0,       /* Last fetch succeeded */
+    SENSOR_HEALTH_BACKOFF,      /* Failing, retried with exponential backoff */
+    SENSOR_HEALTH_OPEN,         /* Breaker open, only periodic recovery probes */
+    SENSOR_HEALTH_ABSENT        /* Not in devicetree or not ready */
+} sensor_health_state_t;
+
+/* Per-device health record */
+typedef struct {
+    sensor_health_state_t state;
+    uint32_t consecutive_failures;
+    uint32_t total_failures;
+    uint32_t total_skipped;     /* Fetches suppressed by backoff / breaker */
+    uint32_t last_success_ms;
+    uint32_t next_attempt_ms;
+    int last_error;
+} sensor_health_t;
+
+/* Retry policy */
+#define SENSOR_BACKOFF_BASE_MS     1000     /* First retry delay */
+#define SENSOR_BACKOFF_MAX_MS      16000    /* Backoff ceiling */
+#define SENSOR_BREAKER_THRESHOLD   6        /* Consecutive failures to open */
+#define SENSOR_PROBE_INTERVAL_MS   60000    /* Recovery probe while open */
+
+/* A channel with no valid sample for this long is stale */
+#define SENSOR_STALE_MS            10000
 
 /* Sensor data structure */
 typedef struct {
-    float temperature;     /* in Celsius */
-    float light_level;     /* in lux */
-    float humidity;       /* in percentage */
-    bool temperature_valid;
-    bool light_valid;
-    bool humidity_valid;
-    uint32_t timestamp;   /* Last reading timestamp */
+    float value[SENSOR_CH_COUNT];   /* Scaled, in the channel's unit */
+    bool valid[SENSOR_CH_COUNT];
+    uint32_t timestamp;             /* Last reading timestamp */
+    uint32_t sample_cycles;         /* k_cycle_get_32() once all were sampled */
 } sensor_data_t;
 
 /* Sensor initialization */
@@ -25,10 +90,21 @@ int sensor_manager_init(void);
 /* Read all sensors */
 int sensor_manager_read_all(sensor_data_t *data);
 
-/* Read individual sensors */
-int sensor_manager_read_temperature(float *temp);
-int sensor_manager_read_light(float *light);
-int sensor_manager_read_humidity(float *humidity);
+/* Read a single channel */
+int sensor_manager_read_channel(sensor_ch_t ch, float *value);
+
+/* Channel helpers: value lookup (false if invalid), table entry and short name */
+bool sensor_data_get_channel(const sensor_data_t *data, sensor_ch_t ch, float *value);
+const sensor_channel_info_t* sensor_channel_info(sensor_ch_t ch);
+const char* sensor_channel_name(sensor_ch_t ch);
+
+/* Device health and sample age */
+int sensor_manager_device_count(void);
+int sensor_manager_get_health(sensor_dev_t dev, sensor_health_t *out);
+const char* sensor_device_name(sensor_dev_t dev);
+const char* sensor_health_state_name(sensor_health_state_t state);
+uint32_t sensor_manager_channel_age_ms(sensor_ch_t ch);   /* UINT32_MAX if never read */
+bool sensor_manager_is_stale(sensor_ch_t ch);
 
 /* Sensor status */
 bool sensor_manager_is_ready(void);
@@ -37,4 +113,4 @@ bool sensor_manager_has_error(void);
 /* Get last error string */
 const char* sensor_manager_get_error(void);
 
-#endif /* SENSOR_MANAGER_H */
\ No newline at end of file
+#endif /* SENSOR_MANAGER_H */
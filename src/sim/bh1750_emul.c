@@ -0,0 +1,60 @@
+/**
+ * @file bh1750_emul.c
+ * @brief I2C emulator for the BH1750 light sensor (native_sim)
+ *
+ * Attaches to rohm,bh1750 nodes on an i2c-emul controller. Opcode writes
+ * (power on, mode, MTreg) are accepted and ignored; every 2-byte read
+ * returns the scripted lux as a raw count (lux * 1.2 at the default MTreg).
+ */
+
+#define DT_DRV_COMPAT rohm_bh1750
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/emul.h>
+#include <zephyr/drivers/i2c.h>
+#include <zephyr/drivers/i2c_emul.h>
+#include <zephyr/sys/byteorder.h>
+#include "sim_env.h"
+
+#define BH1750_COUNTS_PER_LUX  1.2f
+
+static int bh1750_emul_transfer(const struct emul *target, struct i2c_msg *msgs,
+                                int num_msgs, int addr)
+{
+    ARG_UNUSED(addr);
+
+    int fault = sim_env_fault(target->dev->name);
+    if (fault) {
+        return fault;
+    }
+
+    for (int i = 0; i < num_msgs; i++) {
+        if (!(msgs[i].flags & I2C_MSG_READ)) {
+            continue;
+        }
+        if (msgs[i].len < 2) {
+            return -EIO;
+        }
+
+        float raw = sim_env_value(SENSOR_CH_LIGHT) * BH1750_COUNTS_PER_LUX;
+        sys_put_be16((uint16_t)CLAMP(raw, 0.0f, 65535.0f), msgs[i].buf);
+    }
+
+    return 0;
+}
+
+static const struct i2c_emul_api bh1750_emul_api = {
+    .transfer = bh1750_emul_transfer,
+};
+
+static int bh1750_emul_init(const struct emul *target, const struct device *parent)
+{
+    ARG_UNUSED(target);
+    ARG_UNUSED(parent);
+    return 0;
+}
+
+#define BH1750_EMUL(n) \
+    EMUL_DT_INST_DEFINE(n, bh1750_emul_init, NULL, NULL, &bh1750_emul_api, NULL)
+
+DT_INST_FOREACH_STATUS_OKAY(BH1750_EMUL)
@@ -0,0 +1,64 @@
+/**
+ * @file dht_emul.c
+ * @brief Emulated DHT11 temperature/humidity sensor (native_sim)
+ *
+ * The real DHT driver bit-bangs a GPIO with microsecond timing, which
+ * native_sim cannot reproduce, so this is a sensor driver of its own
+ * that serves the scripted environment with DHT11 (1 unit) resolution.
+ */
+
+#define DT_DRV_COMPAT greenhouse_dht_emul
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <math.h>
+#include "sim_env.h"
+
+struct dht_emul_data {
+    float temperature;
+    float humidity;
+};
+
+static int dht_emul_sample_fetch(const struct device *dev, enum sensor_channel chan)
+{
+    struct dht_emul_data *data = dev->data;
+
+    ARG_UNUSED(chan);
+
+    int fault = sim_env_fault(dev->name);
+    if (fault) {
+        return fault;
+    }
+
+    data->temperature = roundf(sim_env_value(SENSOR_CH_TEMPERATURE));
+    data->humidity = roundf(sim_env_value(SENSOR_CH_HUMIDITY));
+    return 0;
+}
+
+static int dht_emul_channel_get(const struct device *dev, enum sensor_channel chan,
+                                struct sensor_value *val)
+{
+    const struct dht_emul_data *data = dev->data;
+
+    switch (chan) {
+    case SENSOR_CHAN_AMBIENT_TEMP:
+        return sensor_value_from_float(val, data->temperature);
+    case SENSOR_CHAN_HUMIDITY:
+        return sensor_value_from_float(val, data->humidity);
+    default:
+        return -ENOTSUP;
+    }
+}
+
+static const struct sensor_driver_api dht_emul_api = {
+    .sample_fetch = dht_emul_sample_fetch,
+    .channel_get = dht_emul_channel_get,
+};
+
+#define DHT_EMUL_DEFINE(n)                                                  \
+    static struct dht_emul_data dht_emul_data_##n;                          \
+    SENSOR_DEVICE_DT_INST_DEFINE(n, NULL, NULL, &dht_emul_data_##n, NULL,   \
+                                 POST_KERNEL, CONFIG_SENSOR_INIT_PRIORITY,  \
+                                 &dht_emul_api);
+
+DT_INST_FOREACH_STATUS_OKAY(DHT_EMUL_DEFINE)
@@ -0,0 +1,46 @@
+/**
+ * @file lm35_adc_emul.c
+ * @brief Feeds the LM35 ADC channel from the scripted environment (native_sim)
+ *
+ * The LM35 driver itself runs unmodified on top of the ADC emulator; this
+ * only installs a value callback producing 10 mV per degree Celsius.
+ */
+
+#include <zephyr/device.h>
+#include <zephyr/init.h>
+#include <zephyr/drivers/adc/adc_emul.h>
+#include "sim_env.h"
+
+#define LM35_NODE        DT_ALIAS(lm35)
+#define LM35_MV_PER_C    10.0f
+
+static int lm35_emul_value(const struct device *dev, unsigned int chan,
+                           void *data, uint32_t *result)
+{
+    ARG_UNUSED(dev);
+    ARG_UNUSED(chan);
+    ARG_UNUSED(data);
+
+    int fault = sim_env_fault(DT_NODE_FULL_NAME(LM35_NODE));
+    if (fault) {
+        return fault;
+    }
+
+    float mv = sim_env_value(SENSOR_CH_TEMPERATURE) * LM35_MV_PER_C;
+    *result = (mv > 0.0f) ? (uint32_t)mv : 0u;
+    return 0;
+}
+
+static int lm35_emul_init(void)
+{
+    const struct device *adc = DEVICE_DT_GET(DT_IO_CHANNELS_CTLR(LM35_NODE));
+
+    if (!device_is_ready(adc)) {
+        return -ENODEV;
+    }
+
+    return adc_emul_value_func_set(adc, DT_IO_CHANNELS_INPUT(LM35_NODE),
+                                   lm35_emul_value, NULL);
+}
+
+SYS_INIT(lm35_emul_init, APPLICATION, 1);
@@ -0,0 +1,71 @@
+/**
+ * @file pwm_emul.c
+ * @brief Emulated PWM controller (native_sim)
+ *
+ * native_sim has no PWM driver; this one stands in for the K64 FTM
+ * behind the fan-pwm alias and records what is set, nothing more.
+ */
+
+#define DT_DRV_COMPAT greenhouse_pwm_emul
+
+#include <zephyr/device.h>
+#include <zephyr/drivers/pwm.h>
+#include "pwm_emul.h"
+
+#define PWM_EMUL_CLOCK_HZ   1000000
+
+struct pwm_emul_data {
+    uint32_t period[PWM_EMUL_CHANNELS];
+    uint32_t pulse[PWM_EMUL_CHANNELS];
+};
+
+static int pwm_emul_set_cycles(const struct device *dev, uint32_t channel,
+                               uint32_t period_cycles, uint32_t pulse_cycles,
+                               pwm_flags_t flags)
+{
+    struct pwm_emul_data *data = dev->data;
+
+    ARG_UNUSED(flags);
+
+    if (channel >= PWM_EMUL_CHANNELS || pulse_cycles > period_cycles) {
+        return -EINVAL;
+    }
+    data->period[channel] = period_cycles;
+    data->pulse[channel] = pulse_cycles;
+    return 0;
+}
+
+static int pwm_emul_get_cycles_per_sec(const struct device *dev, uint32_t channel,
+                                       uint64_t *cycles)
+{
+    ARG_UNUSED(dev);
+
+    if (channel >= PWM_EMUL_CHANNELS) {
+        return -EINVAL;
+    }
+    *cycles = PWM_EMUL_CLOCK_HZ;
+    return 0;
+}
+
+uint32_t pwm_emul_duty_permille(const struct device *dev, uint32_t channel)
+{
+    const struct pwm_emul_data *data = dev->data;
+
+    if (channel >= PWM_EMUL_CHANNELS || data->period[channel] == 0) {
+        return 0;
+    }
+    return (uint32_t)((uint64_t)data->pulse[channel] * 1000 / data->period[channel]);
+}
+
+static const struct pwm_driver_api pwm_emul_api = {
+    .set_cycles = pwm_emul_set_cycles,
+    .get_cycles_per_sec = pwm_emul_get_cycles_per_sec,
+};
+
+#define PWM_EMUL_DEFINE(n)                                                  \
+    static struct pwm_emul_data pwm_emul_data_##n;                          \
+    DEVICE_DT_INST_DEFINE(n, NULL, NULL, &pwm_emul_data_##n, NULL,          \
+                          POST_KERNEL, CONFIG_PWM_INIT_PRIORITY,            \
+                          &pwm_emul_api);
+
+DT_INST_FOREACH_STATUS_OKAY(PWM_EMUL_DEFINE)
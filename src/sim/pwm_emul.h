@@ -0,0 +1,20 @@
+/**
+ * @file pwm_emul.h
+ * @brief Emulated PWM controller (native_sim)
+ *
+ * Accepts pwm_set_cycles on PWM_EMUL_CHANNELS channels at a 1 MHz
+ * clock and keeps the last period and pulse, so the plant model can
+ * read the duty the firmware drives.
+ */
+
+#ifndef PWM_EMUL_H
+#define PWM_EMUL_H
+
+#include <zephyr/device.h>
+
+#define PWM_EMUL_CHANNELS   4
+
+/* Duty last set on 'channel' in permille (0 before the first set) */
+uint32_t pwm_emul_duty_permille(const struct device *dev, uint32_t channel);
+
+#endif /* PWM_EMUL_H */
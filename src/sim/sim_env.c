@@ -0,0 +1,242 @@
+/**
+ * @file sim_env.c
+ * @brief Scripted environment for the emulated sensors (native_sim)
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/logging/log.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "sim_env.h"
+#include "sim_plant.h"
+
+LOG_MODULE_REGISTER(sim_env, LOG_LEVEL_INF);
+
+#define PI_F  3.14159265f
+
+typedef struct {
+    sensor_ch_t ch;
+    float base;
+    float amplitude;
+    float period_s;
+    float phase_s;
+    float noise;
+} sim_wave_t;
+
+typedef struct {
+    sensor_ch_t ch;
+    float start_s;
+    float end_s;
+    float offset;
+} sim_step_t;
+
+typedef struct {
+    char dev[16];
+    float start_s;
+    float end_s;
+    int err;
+} sim_fault_t;
+
+/* Script text, generated from SIM_ENV_SCRIPT at build time */
+static const char script[] = {
+#include "sim_env_script.inc"
+    0
+};
+
+static sim_wave_t waves[SIM_ENV_MAX_WAVES];
+static sim_step_t steps[SIM_ENV_MAX_STEPS];
+static sim_fault_t faults[SIM_ENV_MAX_FAULTS];
+static int wave_count, step_count, fault_count;
+
+/* Per-channel xorshift state, so runs are reproducible */
+static uint32_t noise_state[SENSOR_CH_COUNT];
+
+static bool lookup_channel(const char *name, sensor_ch_t *ch)
+{
+    for (int i = 0; i < SENSOR_CH_COUNT; i++) {
+        if (strcmp(name, sensor_channel_name((sensor_ch_t)i)) == 0) {
+            *ch = (sensor_ch_t)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Parses one script line; returns false on a malformed directive */
+static bool parse_line(const char *line)
+{
+    char kind[8], name[16];
+    float a, b, c, d, e;
+    int err;
+
+    if (sscanf(line, "%7s", kind) != 1 || kind[0] == '#') {
+        return true;    /* Blank line or comment */
+    }
+
+    if (strcmp(kind, "wave") == 0 && wave_count < SIM_ENV_MAX_WAVES) {
+        sim_wave_t *w = &waves[wave_count];
+        if (sscanf(line, "%*s %15s %f %f %f %f %f", name, &a, &b, &c, &d, &e) != 6 ||
+            !lookup_channel(name, &w->ch) || c <= 0.0f) {
+            return false;
+        }
+        w->base = a; w->amplitude = b; w->period_s = c; w->phase_s = d; w->noise = e;
+        wave_count++;
+        return true;
+    }
+
+    if (strcmp(kind, "step") == 0 && step_count < SIM_ENV_MAX_STEPS) {
+        sim_step_t *s = &steps[step_count];
+        if (sscanf(line, "%*s %15s %f %f %f", name, &a, &b, &c) != 4 ||
+            !lookup_channel(name, &s->ch)) {
+            return false;
+        }
+        s->start_s = a; s->end_s = b; s->offset = c;
+        step_count++;
+        return true;
+    }
+
+    if (strcmp(kind, "fail") == 0 && fault_count < SIM_ENV_MAX_FAULTS) {
+        sim_fault_t *f = &faults[fault_count];
+        int n = sscanf(line, "%*s %15s %f %f %d", f->dev, &a, &b, &err);
+        if (n < 3) {
+            return false;
+        }
+        f->start_s = a; f->end_s = b; f->err = (n == 4) ? err : -EIO;
+        fault_count++;
+        return true;
+    }
+
+    return false;
+}
+
+static int sim_env_init(void)
+{
+    const char *p = script;
+    char line[96];
+    int line_no = 0;
+
+    while (*p) {
+        size_t len = strcspn(p, "\n");
+        size_t copy = MIN(len, sizeof(line) - 1);
+
+        memcpy(line, p, copy);
+        line[copy] = '\0';
+        line_no++;
+
+        if (!parse_line(line)) {
+            LOG_WRN("Script line %d ignored: %s", line_no, line);
+        }
+
+        p += len;
+        if (*p == '\n') p++;
+    }
+
+    for (int i = 0; i < SENSOR_CH_COUNT; i++) {
+        noise_state[i] = 0x9E3779B9u * (uint32_t)(i + 1);
+    }
+
+    LOG_INF("Environment script: %d waves, %d steps, %d faults",
+            wave_count, step_count, fault_count);
+    return 0;
+}
+
+SYS_INIT(sim_env_init, APPLICATION, 0);
+
+/* Uniform noise in [-1, 1) */
+static float next_noise(sensor_ch_t ch)
+{
+    uint32_t x = noise_state[ch];
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    noise_state[ch] = x;
+
+    return (float)(x >> 8) / (float)(1u << 23) - 1.0f;
+}
+
+static float now_s(void)
+{
+    return (float)((double)k_uptime_get() / 1000.0);
+}
+
+/* Waveforms and steps at time t, without noise */
+static float scripted_value(sensor_ch_t ch, float t)
+{
+    float value = 0.0f;
+
+    for (int i = 0; i < wave_count; i++) {
+        const sim_wave_t *w = &waves[i];
+        if (w->ch == ch) {
+            value += w->base +
+                     w->amplitude * sinf(2.0f * PI_F * fmodf(t + w->phase_s, w->period_s) /
+                                         w->period_s);
+        }
+    }
+
+    for (int i = 0; i < step_count; i++) {
+        const sim_step_t *s = &steps[i];
+        if (s->ch == ch && t >= s->start_s && t < s->end_s) {
+            value += s->offset;
+        }
+    }
+    return value;
+}
+
+/* Physical limits of the emulated quantities */
+static float clamp_value(sensor_ch_t ch, float value)
+{
+    if (ch == SENSOR_CH_LIGHT && value < 0.0f) {
+        value = 0.0f;
+    } else if (ch == SENSOR_CH_HUMIDITY) {
+        value = CLAMP(value, 0.0f, 100.0f);
+    }
+    return value;
+}
+
+float sim_env_outdoor(sensor_ch_t ch)
+{
+    if (ch >= SENSOR_CH_COUNT) {
+        return NAN;
+    }
+    return clamp_value(ch, scripted_value(ch, now_s()));
+}
+
+float sim_env_value(sensor_ch_t ch)
+{
+    float value;
+
+    if (ch >= SENSOR_CH_COUNT) {
+        return NAN;
+    }
+
+#ifdef CONFIG_GREENHOUSE_SIM_PLANT
+    /* The script is the weather; the sensors see the house */
+    value = sim_plant_value(ch);
+#else
+    value = scripted_value(ch, now_s());
+#endif
+
+    for (int i = 0; i < wave_count; i++) {
+        if (waves[i].ch == ch) {
+            value += waves[i].noise * next_noise(ch);
+        }
+    }
+
+    return clamp_value(ch, value);
+}
+
+int sim_env_fault(const char *name)
+{
+    float t = now_s();
+
+    for (int i = 0; i < fault_count; i++) {
+        const sim_fault_t *f = &faults[i];
+        if (strcmp(f->dev, name) == 0 && t >= f->start_s && t < f->end_s) {
+            return f->err;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,34 @@
+/**
+ * @file sim_env.h
+ * @brief Scripted environment driving the emulated sensors (native_sim)
+ *
+ * The script is compiled in from SIM_ENV_SCRIPT (CMake cache variable,
+ * default src/sim/env_default.txt). Time is simulated uptime, so with
+ * real-time slowdown disabled a day of script runs in seconds.
+ *
+ * With CONFIG_GREENHOUSE_SIM_PLANT the script describes the weather
+ * outside the house and the sensors read the plant model (sim_plant.h)
+ * instead; noise and faults still come from the script.
+ */
+
+#ifndef SIM_ENV_H
+#define SIM_ENV_H
+
+#include "sensor_manager.h"
+
+/* Script capacity */
+#define SIM_ENV_MAX_WAVES    8
+#define SIM_ENV_MAX_STEPS    8
+#define SIM_ENV_MAX_FAULTS   8
+
+/* Value a sensor reads at the current uptime: waveforms + steps, or
+ * the plant model, plus noise */
+float sim_env_value(sensor_ch_t ch);
+
+/* Waveforms + steps at the current uptime, without noise */
+float sim_env_outdoor(sensor_ch_t ch);
+
+/* 0, or the negative errno device 'name' (its node name) must return now */
+int sim_env_fault(const char *name);
+
+#endif /* SIM_ENV_H */
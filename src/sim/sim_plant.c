@@ -0,0 +1,313 @@
+/**
+ * @file sim_plant.c
+ * @brief Greenhouse plant model closing the loop on native_sim
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/init.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+#include <math.h>
+#include <posix_board_if.h>
+#include "sim_plant.h"
+#include "sim_env.h"
+#include "pwm_emul.h"
+#include "actuator_output.h"
+#include "env_controller.h"
+#include "mode_controller.h"
+
+LOG_MODULE_REGISTER(sim_plant, LOG_LEVEL_INF);
+
+#define PLANT_STEP_MS       1000
+#define PLANT_STEP_S        (PLANT_STEP_MS / 1000.0f)
+#define SUMMARY_DAY_S       86400
+
+/* Model constants, per second of simulated time */
+#define TAU_ENVELOPE_S      5400.0f     /* Air exchange through the cover */
+#define TAU_VENT_S          300.0f      /* Extra exchange with the fan running */
+#define SOLAR_HEAT          2.0e-6f     /* C/s per lux of sunlight */
+#define LAMP_HEAT           2.5e-4f     /* C/s with the grow light on */
+#define TRANSPIRATION       1.0e-3f     /* %RH/s, night */
+#define TRANSPIRATION_SUN   2.0e-6f     /* %RH/s per lux of sunlight */
+#define IRRIGATION_RH       0.03f       /* %RH/s with the pump running */
+#define RH_PER_C            0.06f       /* Relative RH drop per C of warming */
+#define TRANSMISSION        0.7f        /* Sunlight reaching the sensor */
+#define LAMP_LUX            600.0f
+
+/* Actuator pins, read back from the GPIO emulator */
+static const struct gpio_dt_spec pins[ACTUATOR_COUNT] = {
+    [ACTUATOR_FAN]        = GPIO_DT_SPEC_GET(DT_ALIAS(fan_actuator), gpios),
+    [ACTUATOR_IRRIGATION] = GPIO_DT_SPEC_GET(DT_ALIAS(irrigation_actuator), gpios),
+    [ACTUATOR_LIGHT]      = GPIO_DT_SPEC_GET(DT_ALIAS(light_actuator), gpios),
+};
+
+/* Fan speed from the PWM emulator; without it the fan runs flat out */
+#if DT_NODE_HAS_STATUS(DT_ALIAS(fan_pwm), okay) && defined(CONFIG_PWM)
+#define FAN_PWM_DEV         DEVICE_DT_GET(DT_PWMS_CTLR(DT_ALIAS(fan_pwm)))
+#define FAN_PWM_CHANNEL     DT_PWMS_CHANNEL(DT_ALIAS(fan_pwm))
+
+static float fan_speed(void)
+{
+    return pwm_emul_duty_permille(FAN_PWM_DEV, FAN_PWM_CHANNEL) / 1000.0f;
+}
+#else
+static float fan_speed(void)
+{
+    return 1.0f;
+}
+#endif
+
+/* Accepted distance from the setpoint below and above it. The house has
+ * no shading, so any amount of light over the setpoint is fine. */
+static const float band_below[SENSOR_CH_COUNT] = {
+    [SENSOR_CH_TEMPERATURE] = 1.0f,
+    [SENSOR_CH_HUMIDITY]    = 5.0f,
+    [SENSOR_CH_LIGHT]       = 50.0f,
+};
+static const float band_above[SENSOR_CH_COUNT] = {
+    [SENSOR_CH_TEMPERATURE] = 1.0f,
+    [SENSOR_CH_HUMIDITY]    = 5.0f,
+    [SENSOR_CH_LIGHT]       = INFINITY,
+};
+
+typedef struct {
+    uint32_t in_band_s;
+    bool settled;               /* Has been in band at least once */
+    float overshoot;            /* Worst excursion past the band since */
+} channel_metrics_t;
+
+typedef struct {
+    uint32_t cycles;            /* Off to on transitions */
+    uint32_t on_s;
+} actuator_metrics_t;
+
+/* State the sensors read (under plant_lock) */
+static float state[SENSOR_CH_COUNT];
+static struct k_spinlock plant_lock;
+
+/* Owned by the plant thread; the metrics are written under
+ * metrics_lock for sim_plant_get_metrics */
+static uint32_t elapsed_s;
+static uint32_t outputs;
+static channel_metrics_t ch_metrics[SENSOR_CH_COUNT];
+static actuator_metrics_t act_metrics[ACTUATOR_COUNT];
+static struct k_spinlock metrics_lock;
+
+float sim_plant_value(sensor_ch_t ch)
+{
+    k_spinlock_key_t key = k_spin_lock(&plant_lock);
+    float value = state[ch];
+
+    k_spin_unlock(&plant_lock, key);
+    return value;
+}
+
+/* The house starts in equilibrium with the weather */
+static int sim_plant_init(void)
+{
+    for (int i = 0; i < SENSOR_CH_COUNT; i++) {
+        state[i] = sim_env_outdoor((sensor_ch_t)i);
+    }
+    return 0;
+}
+
+/* After sim_env (APPLICATION 0), before any sensor is read */
+SYS_INIT(sim_plant_init, APPLICATION, 2);
+
+static uint32_t read_outputs(void)
+{
+    uint32_t mask = 0;
+
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        int level = gpio_emul_output_get(pins[i].port, pins[i].pin);
+
+        if (level < 0) {
+            continue;
+        }
+        if ((level != 0) != ((pins[i].dt_flags & GPIO_ACTIVE_LOW) != 0)) {
+            mask |= BIT(i);
+        }
+    }
+    return mask;
+}
+
+/* One explicit Euler step; the fastest time constant is minutes */
+static void plant_step(uint32_t on)
+{
+    float t_out = sim_env_outdoor(SENSOR_CH_TEMPERATURE);
+    float h_out = sim_env_outdoor(SENSOR_CH_HUMIDITY);
+    float sun = sim_env_outdoor(SENSOR_CH_LIGHT);
+    bool fan = (on & BIT(ACTUATOR_FAN)) != 0;
+    bool pump = (on & BIT(ACTUATOR_IRRIGATION)) != 0;
+    bool lamp = (on & BIT(ACTUATOR_LIGHT)) != 0;
+    float exchange = 1.0f / TAU_ENVELOPE_S + (fan ? fan_speed() / TAU_VENT_S : 0.0f);
+    float temp, hum, d_temp, d_hum;
+
+    k_spinlock_key_t key = k_spin_lock(&plant_lock);
+    temp = state[SENSOR_CH_TEMPERATURE];
+    hum = state[SENSOR_CH_HUMIDITY];
+    k_spin_unlock(&plant_lock, key);
+
+    d_temp = (exchange * (t_out - temp) + SOLAR_HEAT * sun +
+              (lamp ? LAMP_HEAT : 0.0f)) * PLANT_STEP_S;
+    d_hum = (exchange * (h_out - hum) + TRANSPIRATION + TRANSPIRATION_SUN * sun +
+             (pump ? IRRIGATION_RH : 0.0f)) * PLANT_STEP_S -
+            RH_PER_C * hum * d_temp;
+
+    key = k_spin_lock(&plant_lock);
+    state[SENSOR_CH_TEMPERATURE] = temp + d_temp;
+    state[SENSOR_CH_HUMIDITY] = CLAMP(hum + d_hum, 0.0f, 100.0f);
+    state[SENSOR_CH_LIGHT] = TRANSMISSION * sun + (lamp ? LAMP_LUX : 0.0f);
+    k_spin_unlock(&plant_lock, key);
+}
+
+static void account(uint32_t on, const env_setpoints_t *sp)
+{
+    const float target[SENSOR_CH_COUNT] = {
+        [SENSOR_CH_TEMPERATURE] = sp->target_temperature,
+        [SENSOR_CH_HUMIDITY]    = sp->target_humidity,
+        [SENSOR_CH_LIGHT]       = sp->target_light,
+    };
+
+    float value[SENSOR_CH_COUNT];
+
+    for (int i = 0; i < SENSOR_CH_COUNT; i++) {
+        value[i] = sim_plant_value((sensor_ch_t)i);
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&metrics_lock);
+
+    for (int i = 0; i < SENSOR_CH_COUNT; i++) {
+        channel_metrics_t *m = &ch_metrics[i];
+        float err = value[i] - target[i];
+        float past = MAX(err - band_above[i], -err - band_below[i]);
+
+        if (past <= 0.0f) {
+            m->in_band_s++;
+            m->settled = true;
+        } else if (m->settled && past > m->overshoot) {
+            m->overshoot = past;
+        }
+    }
+
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if (on & BIT(i)) {
+            act_metrics[i].on_s++;
+            if ((outputs & BIT(i)) == 0) {
+                act_metrics[i].cycles++;
+            }
+        }
+    }
+    outputs = on;
+
+    k_spin_unlock(&metrics_lock, key);
+}
+
+void sim_plant_get_metrics(sim_plant_metrics_t *out)
+{
+    k_spinlock_key_t key = k_spin_lock(&metrics_lock);
+
+    out->elapsed_s = elapsed_s;
+    for (int i = 0; i < SENSOR_CH_COUNT; i++) {
+        out->in_band_s[i] = ch_metrics[i].in_band_s;
+        out->overshoot[i] = ch_metrics[i].overshoot;
+    }
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        out->cycles[i] = act_metrics[i].cycles;
+        out->on_s[i] = act_metrics[i].on_s;
+    }
+
+    k_spin_unlock(&metrics_lock, key);
+}
+
+static void print_csv(uint32_t on, const env_setpoints_t *sp)
+{
+    printk("CSV,%u,%.2f,%.2f,%.0f,%.2f,%.2f,%.0f,%.1f,%.1f,%.0f,%u,%u,%u\n",
+           elapsed_s,
+           (double)sim_plant_value(SENSOR_CH_TEMPERATURE),
+           (double)sim_plant_value(SENSOR_CH_HUMIDITY),
+           (double)sim_plant_value(SENSOR_CH_LIGHT),
+           (double)sim_env_outdoor(SENSOR_CH_TEMPERATURE),
+           (double)sim_env_outdoor(SENSOR_CH_HUMIDITY),
+           (double)sim_env_outdoor(SENSOR_CH_LIGHT),
+           (double)sp->target_temperature, (double)sp->target_humidity,
+           (double)sp->target_light,
+           (on >> ACTUATOR_FAN) & 1, (on >> ACTUATOR_IRRIGATION) & 1,
+           (on >> ACTUATOR_LIGHT) & 1);
+}
+
+static void print_summary(void)
+{
+    printk("Plant summary after %.1f h:\n", (double)elapsed_s / 3600.0);
+
+    for (int i = 0; i < SENSOR_CH_COUNT; i++) {
+        const channel_metrics_t *m = &ch_metrics[i];
+
+        printk("  %-5s in band %5.1f%%  overshoot %.1f%s\n",
+               sensor_channel_name((sensor_ch_t)i),
+               (double)m->in_band_s * 100.0 / elapsed_s, (double)m->overshoot,
+               m->settled ? "" : " (never in band)");
+    }
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        const actuator_metrics_t *m = &act_metrics[i];
+
+        printk("  %-5s cycles %u  on %.2f h\n", actuator_name((actuator_id_t)i),
+               m->cycles, (double)m->on_s / 3600.0);
+    }
+}
+
+static void sim_plant_thread(void *p1, void *p2, void *p3)
+{
+    struct k_timer step_timer;
+    env_setpoints_t sp;
+    uint32_t end_s = CONFIG_GREENHOUSE_SIM_PLANT_HOURS * 3600U;
+
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        if (!gpio_is_ready_dt(&pins[i])) {
+            LOG_ERR("Actuator pin %d not ready, plant stopped", i);
+            return;
+        }
+    }
+
+    LOG_INF("Plant model running, %s", end_s ? "timed scenario" : "no time limit");
+    printk("CSV,t_s,temp,hum,lux,out_temp,out_hum,sun,temp_sp,hum_sp,lux_sp,fan,pump,light\n");
+
+    k_timer_init(&step_timer, NULL, NULL);
+    k_timer_start(&step_timer, K_MSEC(PLANT_STEP_MS), K_MSEC(PLANT_STEP_MS));
+
+    while (1) {
+        k_timer_status_sync(&step_timer);
+
+        uint32_t on = read_outputs();
+
+        plant_step(on);
+        elapsed_s++;
+
+        /* The scenario is closed-loop: once main has brought the
+         * controller up, go on as if the mode button was pressed */
+        if (elapsed_s == 1) {
+            mode_controller_set_mode(ENV_MODE_ADJUSTING);
+        }
+
+        env_controller_get_setpoints(&sp);
+        account(on, &sp);
+
+        if (CONFIG_GREENHOUSE_SIM_PLANT_CSV_PERIOD > 0 &&
+            elapsed_s % CONFIG_GREENHOUSE_SIM_PLANT_CSV_PERIOD == 0) {
+            print_csv(on, &sp);
+        }
+
+        if (elapsed_s == end_s) {
+            print_summary();
+            posix_exit(0);
+        } else if (elapsed_s % SUMMARY_DAY_S == 0) {
+            print_summary();
+        }
+    }
+}
+
+/* Above the application threads, so the plant steps on time */
+K_THREAD_DEFINE(sim_plant_tid, 2048, sim_plant_thread, NULL, NULL, NULL,
+                K_PRIO_PREEMPT(0), 0, 0);
@@ -0,0 +1,45 @@
+/**
+ * @file sim_plant.h
+ * @brief Greenhouse plant model closing the loop on native_sim
+ *
+ * A lumped model of the house: air temperature relaxes to the outside
+ * temperature through the envelope and, much faster, through the fan
+ * (in proportion to its PWM duty); sunlight and the grow light heat it.
+ * Humidity relaxes the same way, rises with transpiration and
+ * irrigation and falls as the air warms.
+ * Light is transmitted sunlight plus the grow light. The weather comes
+ * from the environment script (sim_env_outdoor), the actuator states
+ * from the emulated GPIO pins and the fan duty from the PWM emulator,
+ * so the model sees exactly what the firmware drives.
+ *
+ * The model steps once per simulated second. It prints a CSV row every
+ * CONFIG_GREENHOUSE_SIM_PLANT_CSV_PERIOD seconds ("CSV," prefix, grep it
+ * out of the console) and a summary of time-in-band, overshoot and
+ * actuator cycles every simulated day. After
+ * CONFIG_GREENHOUSE_SIM_PLANT_HOURS it prints the final summary and
+ * exits, so a 24 h scenario is one run of zephyr.exe. The scenario
+ * switches the controller to ADJUSTING after the first second.
+ */
+
+#ifndef SIM_PLANT_H
+#define SIM_PLANT_H
+
+#include "sensor_manager.h"
+#include "actuator_output.h"
+
+/* Plant state a sensor on channel 'ch' sees, before sensor noise */
+float sim_plant_value(sensor_ch_t ch);
+
+/* Summary metrics since the start, for the closed-loop self-tests.
+ * Take two copies and subtract to compare controller modes. */
+typedef struct {
+    uint32_t elapsed_s;
+    uint32_t in_band_s[SENSOR_CH_COUNT];
+    float overshoot[SENSOR_CH_COUNT];   /* Worst excursion past the band */
+    uint32_t cycles[ACTUATOR_COUNT];    /* Off to on transitions */
+    uint32_t on_s[ACTUATOR_COUNT];
+} sim_plant_metrics_t;
+
+void sim_plant_get_metrics(sim_plant_metrics_t *out);
+
+#endif /* SIM_PLANT_H */
@@ -0,0 +1,90 @@
+/**
+ * @file sim_test.c
+ * @brief Check bookkeeping and verdict of the native_sim self-tests
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/serial/uart_emul.h>
+#include <zephyr/sys/printk.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <posix_board_if.h>
+#include "sim_test.h"
+
+#define TEST_STACK_SIZE     2048
+
+static const struct device *const bt_uart = DEVICE_DT_GET(DT_NODELABEL(uart3));
+
+K_THREAD_STACK_DEFINE(test_stack, TEST_STACK_SIZE);
+static struct k_thread test_thread;
+
+static uint32_t checks, failed;
+
+void sim_test_spawn(k_thread_entry_t entry)
+{
+    /* Below the plant model, above the application workers */
+    k_thread_create(&test_thread, test_stack, K_THREAD_STACK_SIZEOF(test_stack),
+                    entry, NULL, NULL, NULL, K_PRIO_PREEMPT(1), 0, K_NO_WAIT);
+}
+
+void sim_test_sleep_until(uint32_t s)
+{
+    int64_t left = (int64_t)s * 1000 - k_uptime_get();
+
+    if (left > 0) {
+        k_sleep(K_MSEC(left));
+    }
+}
+
+void sim_test_bt_send(const char *line)
+{
+    uart_emul_flush_tx_data(bt_uart);
+    uart_emul_put_rx_data(bt_uart, (const uint8_t *)line, strlen(line));
+    uart_emul_put_rx_data(bt_uart, (const uint8_t *)"\r\n", 2);
+}
+
+void sim_test_bt_put(const char *data)
+{
+    uart_emul_put_rx_data(bt_uart, (const uint8_t *)data, strlen(data));
+}
+
+size_t sim_test_bt_read(char *buf, size_t size, int32_t ms)
+{
+    size_t len = 0;
+
+    for (int32_t t = 0; t < ms; t++) {
+        k_msleep(1);
+        len += uart_emul_get_tx_data(bt_uart, (uint8_t *)&buf[len], size - 1 - len);
+    }
+    buf[len] = '\0';
+    return len;
+}
+
+void sim_test_check(bool ok, const char *fmt, ...)
+{
+    char msg[120];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    checks++;
+    if (!ok) {
+        failed++;
+    }
+    printk("  %s %s\n", ok ? "ok  " : "FAIL", msg);
+}
+
+FUNC_NORETURN void sim_test_finish(const char *name)
+{
+    if (checks > 0 && failed == 0) {
+        printk("SIM TEST %s: PASS\n", name);
+    } else {
+        printk("SIM TEST %s: FAIL (%u of %u checks)\n", name, failed, checks);
+    }
+    posix_exit((checks > 0 && failed == 0) ? 0 : 1);
+    CODE_UNREACHABLE;
+}
@@ -0,0 +1,54 @@
+/**
+ * @file sim_test.h
+ * @brief Self-tests of the application on native_sim (twister, sample.yaml)
+ *
+ * One CONFIG_GREENHOUSE_SIM_TEST_* choice selects the test built into
+ * zephyr.exe. main() calls sim_test_start() once the application is up
+ * and before the sensor cycle starts. A module test runs to completion
+ * right there; a closed-loop test starts its own thread and returns, so
+ * the application keeps running against the plant model.
+ *
+ * Every check prints one line. sim_test_finish() prints the verdict
+ *
+ *   SIM TEST <name>: PASS          or
+ *   SIM TEST <name>: FAIL (<n> of <m> checks)
+ *
+ * that sample.yaml matches, and exits with status 0 or 1.
+ */
+
+#ifndef SIM_TEST_H
+#define SIM_TEST_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <zephyr/kernel.h>
+
+/* Provided by the selected test */
+void sim_test_start(void);
+
+/* Runs 'entry' on the test thread and returns (closed-loop tests) */
+void sim_test_spawn(k_thread_entry_t entry);
+
+/* Sleeps until 's' seconds of simulated uptime */
+void sim_test_sleep_until(uint32_t s);
+
+/* Sends a command line to the Bluetooth UART emulator (the terminator
+ * is added). Output not yet read is discarded first, so replies never
+ * stall on a full emulated TX FIFO. */
+void sim_test_bt_send(const char *line);
+
+/* Puts raw bytes on the Bluetooth UART emulator, no terminator added
+ * and no output discarded (partial lines, bursts) */
+void sim_test_bt_put(const char *data);
+
+/* Collects Bluetooth output for 'ms' of simulated time into 'buf'
+ * (NUL-terminated); returns its length */
+size_t sim_test_bt_read(char *buf, size_t size, int32_t ms);
+
+/* Records one check; the message is printf-style */
+void sim_test_check(bool ok, const char *fmt, ...);
+
+/* Prints the verdict and exits zephyr.exe */
+FUNC_NORETURN void sim_test_finish(const char *name);
+
+#endif /* SIM_TEST_H */
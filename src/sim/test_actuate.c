@@ -0,0 +1,73 @@
+/**
+ * @file test_actuate.c
+ * @brief Command and threshold to GPIO latency (native_sim self-test)
+ *
+ * Sends setpoint commands through the Bluetooth UART emulator that
+ * switch the grow light on and off, and reads the pin back from the
+ * GPIO emulator ADJUST_LATENCY_BUDGET_US later: the pin itself must
+ * have moved by then. The plant then runs for a while so the fan and
+ * pump cross their thresholds on their own; the ACTUATE figures, now
+ * measured from the line arrival and the sensor sample, must stay
+ * within the budget for every transition.
+ *
+ * Times are simulated: they include every wait on the way (queues,
+ * work items, the writer thread) but not instruction cost.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/sys/printk.h>
+#include "sim_test.h"
+#include "adjust_manager.h"
+
+#define COMMANDS            6
+#define LIGHT_HOLD_MS       15000   /* Past the light's minimum on/off time */
+#define PLANT_RUN_S         1800
+
+static const struct gpio_dt_spec light = GPIO_DT_SPEC_GET(DT_ALIAS(light_actuator), gpios);
+
+static bool light_pin_on(void)
+{
+    int level = gpio_emul_output_get(light.port, light.pin);
+
+    return (level > 0) != ((light.dt_flags & GPIO_ACTIVE_LOW) != 0);
+}
+
+static void test_thread(void *p1, void *p2, void *p3)
+{
+    adjust_latency_t lat;
+
+    /* Plant in ADJUSTING, past the light's first minimum time */
+    sim_test_sleep_until(20);
+
+    for (int i = 0; i < COMMANDS; i++) {
+        bool on = (i & 1) != 0;
+
+        sim_test_bt_send(on ? "TEMP=25,HUM=60,LUX=65000" : "TEMP=25,HUM=60,LUX=0");
+        k_usleep(ADJUST_LATENCY_BUDGET_US);
+        sim_test_check(light_pin_on() == on, "LUX=%s: light pin %s within %u us",
+                       on ? "65000" : "0", light_pin_on() ? "on" : "off",
+                       ADJUST_LATENCY_BUDGET_US);
+
+        k_msleep(LIGHT_HOLD_MS);
+    }
+
+    /* Threshold crossings from the sensor samples */
+    sim_test_sleep_until(PLANT_RUN_S);
+
+    adjust_manager_get_latency(&lat);
+    printk("  ACTUATE: n=%u avg=%u us max=%u us over budget=%u\n",
+           lat.transitions, lat.avg_us, lat.max_us, lat.over_budget);
+    sim_test_check(lat.transitions > COMMANDS, "%u transitions", lat.transitions);
+    sim_test_check(lat.over_budget == 0 && lat.max_us < ADJUST_LATENCY_BUDGET_US,
+                   "every transition within %u us of its sample or command",
+                   ADJUST_LATENCY_BUDGET_US);
+
+    sim_test_finish("actuate");
+}
+
+void sim_test_start(void)
+{
+    sim_test_spawn(test_thread);
+}
@@ -0,0 +1,128 @@
+/**
+ * @file test_bus.c
+ * @brief zbus backbone against the mutex-and-poll design (native_sim self-test)
+ *
+ * Before the channels, the controller state sat behind a k_mutex and
+ * every consumer copied it on its own cadence (the main loop every
+ * SENSOR_UPDATE_MS). This test runs that design next to the real one:
+ * each change is written both to a mutex-protected copy, polled by a
+ * thread at the old cadence, and through env_controller, whose
+ * setpoints channel queues the actuator evaluation. It compares the
+ * change-to-consume latency of both and prints the static RAM each
+ * design spends on moving the state.
+ *
+ * Latency is simulated time: it counts waiting for a poll or a busy
+ * thread, not instruction cost, which native_sim does not model.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include "sim_test.h"
+#include "app_channels.h"
+
+#define CHANGES             20
+#define POLL_MS             1000    /* Old main loop cadence */
+#define STACK_SIZE          1024
+
+/* The mutex design: shared copy plus a change counter */
+static K_MUTEX_DEFINE(legacy_lock);
+static struct {
+    env_setpoints_t setpoints;
+    uint32_t changes;
+    int64_t changed_ms;
+} legacy;
+
+static uint32_t polled_changes;
+static int64_t polled_sum_ms, polled_max_ms;
+static volatile bool done;
+
+K_THREAD_STACK_DEFINE(poll_stack, STACK_SIZE);
+static struct k_thread poll_thread;
+
+static void poll_entry(void *p1, void *p2, void *p3)
+{
+    uint32_t seen = 0;
+
+    while (!done) {
+        uint32_t changes;
+        int64_t changed_ms;
+
+        k_mutex_lock(&legacy_lock, K_FOREVER);
+        changes = legacy.changes;
+        changed_ms = legacy.changed_ms;
+        k_mutex_unlock(&legacy_lock);
+
+        if (changes != seen) {
+            int64_t wait = k_uptime_get() - changed_ms;
+
+            seen = changes;
+            polled_changes++;
+            polled_sum_ms += wait;
+            if (wait > polled_max_ms) {
+                polled_max_ms = wait;
+            }
+        }
+        k_msleep(POLL_MS);
+    }
+}
+
+static size_t channel_bytes(const struct zbus_channel *chan)
+{
+    return sizeof(struct zbus_channel) + sizeof(struct zbus_channel_data) +
+           zbus_chan_msg_size(chan);
+}
+
+void sim_test_start(void)
+{
+    env_setpoints_t sp;
+    app_latency_t lat;
+    uint32_t polled_avg_ms;
+    size_t bus_bytes, legacy_bytes;
+
+    k_thread_create(&poll_thread, poll_stack, K_THREAD_STACK_SIZEOF(poll_stack),
+                    poll_entry, NULL, NULL, NULL, K_PRIO_PREEMPT(4), 0, K_NO_WAIT);
+
+    env_controller_get_setpoints(&sp);
+    for (int i = 0; i < CHANGES; i++) {
+        /* Changes land anywhere within the poll period */
+        k_msleep(POLL_MS + 173 * (i + 1) % POLL_MS);
+        sp.target_temperature = (i & 1) ? 25.0f : 25.5f;
+
+        k_mutex_lock(&legacy_lock, K_FOREVER);
+        legacy.setpoints = sp;
+        legacy.changes++;
+        legacy.changed_ms = k_uptime_get();
+        k_mutex_unlock(&legacy_lock);
+
+        env_controller_set_setpoints(&sp, k_cycle_get_32());
+    }
+    k_msleep(POLL_MS);
+    done = true;
+    k_thread_join(&poll_thread, K_FOREVER);
+
+    /* Every observer notes its latency here, the actuator evaluation
+     * when the work queue picks it up */
+    app_channels_get_latency(&lat);
+    polled_avg_ms = polled_changes ? (uint32_t)(polled_sum_ms / polled_changes) : 0;
+
+    printk("  bus:   %u events, avg %u us, max %u us\n",
+           lat.count, lat.avg_us, lat.max_us);
+    printk("  mutex: %u changes seen, avg %u ms, max %u ms\n",
+           polled_changes, polled_avg_ms, (uint32_t)polled_max_ms);
+
+    sim_test_check(lat.count >= CHANGES, "every change reached the actuator evaluation");
+    sim_test_check(lat.max_us < k_ticks_to_us_floor32(1),
+                   "bus: no change waited for a tick (max %u us)", lat.max_us);
+    sim_test_check(polled_changes == CHANGES && polled_avg_ms > 0,
+                   "mutex: changes waited for the poll (avg %u ms)", polled_avg_ms);
+
+    /* Static RAM spent on moving the state between modules */
+    bus_bytes = channel_bytes(&measurements_chan) + channel_bytes(&setpoints_chan) +
+                channel_bytes(&mode_chan) + channel_bytes(&actuator_chan) +
+                3 * sizeof(struct zbus_observer) + sizeof(struct k_work);
+    legacy_bytes = sizeof(struct k_mutex);
+    printk("  RAM: bus %u bytes (4 channels, 3 listeners, evaluation work), "
+           "mutex %u bytes\n", (unsigned int)bus_bytes, (unsigned int)legacy_bytes);
+
+    sim_test_finish("bus");
+}
@@ -0,0 +1,154 @@
+/**
+ * @file test_chatter.c
+ * @brief Deadband and minimum on/off times on a noisy signal (native_sim self-test)
+ *
+ * Runs without the plant model against env_noisy.txt, where every
+ * reading is its setpoint plus noise wider than the deadband. The test
+ * counts how often the bare < / > comparison the controller used to
+ * make would have switched each actuator, sample by sample, and compares
+ * that with the switches the policy actually made. It also polls the
+ * outputs to check no actuator switched again before the shortest
+ * minimum on/off time and that the on-time counter matches what it saw.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include "sim_test.h"
+#include "adjust_manager.h"
+#include "actuator_output.h"
+
+#define START_S             10
+#define RUN_S               1800
+#define POLL_MS             100
+#define SAMPLE_MS           1000        /* Sensor cycle (main.c) */
+#define MIN_HOLD_MS         10000       /* Shortest minimum time (adjust_manager.c) */
+#define MIN_REDUCTION       5
+
+static const env_setpoints_t sp = {
+    .target_temperature = 25.0f,
+    .target_humidity = 60.0f,
+    .target_light = 400.0f,
+};
+
+typedef struct {
+    uint32_t bare_switches;     /* Flips of the bare comparison */
+    bool bare_on;
+    int64_t last_change_ms;     /* -1 until the first switch seen */
+    int64_t min_interval_ms;
+    uint64_t seen_on_ms;        /* On-time seen by polling */
+} chatter_t;
+
+static chatter_t chatter[ACTUATOR_COUNT];
+
+/* The comparison before the deadband: on whenever the error is positive */
+static bool bare_want(actuator_id_t id, const env_measurements_t *m)
+{
+    switch (id) {
+    case ACTUATOR_FAN:
+        return m->temperature > sp.target_temperature;
+    case ACTUATOR_IRRIGATION:
+        return m->humidity < sp.target_humidity;
+    default:
+        return m->light < sp.target_light;
+    }
+}
+
+static void test_thread(void *p1, void *p2, void *p3)
+{
+    actuator_usage_t before[ACTUATOR_COUNT], after;
+    uint32_t last;
+    env_state_t st;
+
+    /* Plain on/off control of every actuator on the raw readings (the
+     * PWM emulator would otherwise give the fan to the PID) */
+    adjust_manager_set_pid_enabled(false);
+    adjust_manager_set_coordinated(false);
+    adjust_manager_set_irrigation_tp(false);
+    adjust_manager_apply_new_setpoints(&sp, k_cycle_get_32());
+
+    sim_test_sleep_until(START_S);
+    env_controller_read(&st);
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        actuator_output_get_usage((actuator_id_t)i, &before[i]);
+        chatter[i].bare_on = bare_want((actuator_id_t)i, &st.measurements);
+        chatter[i].last_change_ms = -1;
+        chatter[i].min_interval_ms = INT64_MAX;
+    }
+    last = actuator_output_get();
+
+    for (int t = 0; t < RUN_S * 1000 / POLL_MS; t++) {
+        uint32_t on;
+        int64_t now;
+
+        k_msleep(POLL_MS);
+        on = actuator_output_get();
+        now = k_uptime_get();
+
+        for (int i = 0; i < ACTUATOR_COUNT; i++) {
+            chatter_t *c = &chatter[i];
+
+            if (last & BIT(i)) {
+                c->seen_on_ms += POLL_MS;
+            }
+            if ((on ^ last) & BIT(i)) {
+                if (c->last_change_ms >= 0) {
+                    c->min_interval_ms = MIN(c->min_interval_ms, now - c->last_change_ms);
+                }
+                c->last_change_ms = now;
+            }
+        }
+        last = on;
+
+        /* Once per sensor sample */
+        if ((t + 1) % (SAMPLE_MS / POLL_MS) == 0) {
+            env_controller_read(&st);
+            for (int i = 0; i < ACTUATOR_COUNT; i++) {
+                bool want = bare_want((actuator_id_t)i, &st.measurements);
+
+                if (want != chatter[i].bare_on) {
+                    chatter[i].bare_on = want;
+                    chatter[i].bare_switches++;
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        const chatter_t *c = &chatter[i];
+        const char *name = actuator_name((actuator_id_t)i);
+        adjust_counters_t cnt;
+        uint32_t switches, on_ms, tolerance_ms;
+
+        actuator_output_get_usage((actuator_id_t)i, &after);
+        adjust_manager_get_counters((actuator_id_t)i, &cnt);
+        switches = after.switches - before[i].switches;
+        on_ms = (uint32_t)(after.on_ms - before[i].on_ms);
+
+        printk("  %-5s %u switches, bare threshold %u, %u held, on %u%%\n", name,
+               switches, c->bare_switches, cnt.held, on_ms / (RUN_S * 10));
+
+        sim_test_check(c->bare_switches > RUN_S / 4,
+                       "%s: the noise crosses the setpoint (%u flips)", name,
+                       c->bare_switches);
+        sim_test_check(switches > 0 && switches * MIN_REDUCTION <= c->bare_switches,
+                       "%s: at least %dx fewer switches than the bare threshold",
+                       name, MIN_REDUCTION);
+        sim_test_check(c->min_interval_ms >= MIN_HOLD_MS - POLL_MS,
+                       "%s: never switched again within %u ms (least %u ms)", name,
+                       MIN_HOLD_MS, (uint32_t)c->min_interval_ms);
+
+        /* Polling sees each transition up to one period late */
+        tolerance_ms = (switches + 2) * POLL_MS;
+        sim_test_check(on_ms + tolerance_ms >= c->seen_on_ms &&
+                       c->seen_on_ms + tolerance_ms >= on_ms,
+                       "%s: on-time counter %u ms, polled %u ms", name, on_ms,
+                       (uint32_t)c->seen_on_ms);
+    }
+
+    sim_test_finish("chatter");
+}
+
+void sim_test_start(void)
+{
+    sim_test_spawn(test_thread);
+}
@@ -0,0 +1,75 @@
+/**
+ * @file test_coord.c
+ * @brief Fan/pump coordination against independent loops (native_sim self-test)
+ *
+ * Runs the plant through env_coord.txt, where every day has the same
+ * weather: one day with independent fan and pump loops, then one day
+ * coordinated. On-time is taken from what the plant saw on the pins,
+ * so it does not depend on the controller's own accounting. The
+ * coordinated day must run the fan and pump for less time in total and
+ * the pump must have yielded; time in band is printed for both.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include "sim_test.h"
+#include "sim_plant.h"
+#include "adjust_manager.h"
+
+#define DAY_S               86400
+
+static const char *const modes[2] = { "independent", "coordinated" };
+
+static void test_thread(void *p1, void *p2, void *p3)
+{
+    /* Warm days call for the fan, dry ones for the pump */
+    const env_setpoints_t sp = {
+        .target_temperature = 25.0f,
+        .target_humidity = 65.0f,
+        .target_light = 300.0f,
+    };
+    sim_plant_metrics_t m[3];
+    uint32_t on_s[2];
+    adjust_coord_info_t coord;
+
+    adjust_manager_set_coordinated(false);
+    adjust_manager_apply_new_setpoints(&sp, k_cycle_get_32());
+    sim_plant_get_metrics(&m[0]);
+
+    sim_test_sleep_until(DAY_S);
+    sim_plant_get_metrics(&m[1]);
+    adjust_manager_set_coordinated(true);
+
+    sim_test_sleep_until(2 * DAY_S);
+    sim_plant_get_metrics(&m[2]);
+    adjust_manager_get_coordination(&coord);
+
+    for (int i = 0; i < 2; i++) {
+        const sim_plant_metrics_t *a = &m[i], *b = &m[i + 1];
+        uint32_t span = b->elapsed_s - a->elapsed_s;
+
+        on_s[i] = (b->on_s[ACTUATOR_FAN] - a->on_s[ACTUATOR_FAN]) +
+                  (b->on_s[ACTUATOR_IRRIGATION] - a->on_s[ACTUATOR_IRRIGATION]);
+        printk("  %-11s fan %u s, pump %u s, in band TEMP %u%% HUM %u%%\n", modes[i],
+               b->on_s[ACTUATOR_FAN] - a->on_s[ACTUATOR_FAN],
+               b->on_s[ACTUATOR_IRRIGATION] - a->on_s[ACTUATOR_IRRIGATION],
+               (b->in_band_s[SENSOR_CH_TEMPERATURE] - a->in_band_s[SENSOR_CH_TEMPERATURE]) *
+               100 / span,
+               (b->in_band_s[SENSOR_CH_HUMIDITY] - a->in_band_s[SENSOR_CH_HUMIDITY]) *
+               100 / span);
+    }
+    printk("  pump yielded %u s, fan deferred %u s\n", coord.yield_s, coord.defer_s);
+
+    sim_test_check(on_s[0] > 0, "independent loops ran the fan and pump for %u s", on_s[0]);
+    sim_test_check(coord.yield_s > 0, "the pump yielded to the ventilation");
+    sim_test_check(on_s[1] < on_s[0], "coordinated on-time %u s, independent %u s (%d%%)",
+                   on_s[1], on_s[0],
+                   on_s[0] ? (int)(((int64_t)on_s[1] - on_s[0]) * 100 / on_s[0]) : 0);
+
+    sim_test_finish("coord");
+}
+
+void sim_test_start(void)
+{
+    sim_test_spawn(test_thread);
+}
@@ -0,0 +1,117 @@
+/**
+ * @file test_events.c
+ * @brief Event latency and stack RAM of the thread layout (native_sim self-test)
+ *
+ * Presses the mode button on the GPIO emulator and sends Bluetooth
+ * lines through the UART emulator at times spread over the sensor
+ * period, then reads the event-to-handler latency (EVT) and the stack
+ * high-water marks of the threads the layout uses: main, plus the
+ * button and Bluetooth threads unless CONFIG_GREENHOUSE_REACTOR is set.
+ * sample.yaml runs it in both layouts; the two outputs are the
+ * comparison.
+ *
+ * Latency is simulated time. The reactor runs the sensor cycle on the
+ * same thread as the handlers, so an event waits for the cycle's sensor
+ * conversion times; instruction time is not modelled.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/drivers/gpio.h>
+#include <zephyr/drivers/gpio/gpio_emul.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+#include "sim_test.h"
+#include "app_channels.h"
+
+#define EVENTS              20          /* Even: the mode ends where it started */
+#define PERIOD_MS           1000        /* Sensor cycle (main.c) */
+#define MIN_FREE_BYTES      256
+
+#ifdef CONFIG_GREENHOUSE_REACTOR
+#define LAYOUT              "reactor"
+#else
+#define LAYOUT              "threads"
+#endif
+
+static const struct gpio_dt_spec button = GPIO_DT_SPEC_GET(DT_ALIAS(sw0), gpios);
+
+typedef struct {
+    size_t reserved;
+    size_t used;
+    size_t min_free;
+    int threads;
+} stack_use_t;
+
+/* Only the threads that differ between the layouts */
+static void stack_cb(const struct k_thread *thread, void *user_data)
+{
+    stack_use_t *use = user_data;
+    const char *name = k_thread_name_get((struct k_thread *)thread);
+    size_t unused;
+
+    if (name == NULL || (strcmp(name, "main") != 0 && strcmp(name, "bt") != 0 &&
+                         strcmp(name, "mode") != 0)) {
+        return;
+    }
+    if (k_thread_stack_space_get(thread, &unused) != 0) {
+        return;
+    }
+
+    use->reserved += thread->stack_info.size;
+    use->used += thread->stack_info.size - unused;
+    use->min_free = MIN(use->min_free, unused);
+    use->threads++;
+    printk("  stack %-4s %u of %u bytes\n", name,
+           (unsigned int)(thread->stack_info.size - unused),
+           (unsigned int)thread->stack_info.size);
+}
+
+static void test_thread(void *p1, void *p2, void *p3)
+{
+    app_latency_t before, after;
+    stack_use_t use = { .min_free = SIZE_MAX };
+
+    /* Past boot, the banner and the first sensor cycles */
+    sim_test_sleep_until(5);
+    app_channels_get_event_latency(&before);
+
+    for (int i = 0; i < EVENTS; i++) {
+        /* Land anywhere in the sensor period */
+        k_msleep(PERIOD_MS + 173 * (i + 1) % PERIOD_MS);
+
+        gpio_emul_input_set(button.port, button.pin, 1);
+        k_msleep(20);
+        gpio_emul_input_set(button.port, button.pin, 0);
+
+        k_msleep(PERIOD_MS / 2);
+        sim_test_bt_send("IRR");
+    }
+    k_msleep(PERIOD_MS);
+
+    app_channels_get_event_latency(&after);
+    printk("  layout %s: %u events\n", LAYOUT, after.count - before.count);
+    printk("  EVT: avg %u us, max %u us\n", after.avg_us, after.max_us);
+
+    /* Presses and lines are far enough apart never to coalesce */
+    sim_test_check(after.count - before.count == 2 * EVENTS,
+                   "every press and line handled (%u of %u)",
+                   after.count - before.count, 2 * EVENTS);
+    sim_test_check(after.max_us < PERIOD_MS * 1000,
+                   "no event waited a whole sensor period (max %u us)", after.max_us);
+
+    k_thread_foreach(stack_cb, &use);
+    printk("  stacks: %u bytes reserved, %u used, %d threads\n",
+           (unsigned int)use.reserved, (unsigned int)use.used, use.threads);
+    sim_test_check(use.threads == (IS_ENABLED(CONFIG_GREENHOUSE_REACTOR) ? 1 : 3),
+                   "%d layout threads found", use.threads);
+    sim_test_check(use.min_free >= MIN_FREE_BYTES,
+                   "every layout stack keeps %u bytes free (least %u)",
+                   MIN_FREE_BYTES, (unsigned int)use.min_free);
+
+    sim_test_finish("events");
+}
+
+void sim_test_start(void)
+{
+    sim_test_spawn(test_thread);
+}
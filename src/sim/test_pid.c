@@ -0,0 +1,151 @@
+/**
+ * @file test_pid.c
+ * @brief Fan PID against on/off control in closed loop (native_sim self-test)
+ *
+ * Runs the plant against env_pid.txt, where the sun heats the house
+ * and only the fan cools it. The same scenario is run twice, first with
+ * on/off control and then with the PID driving the fan through the PWM
+ * emulator: hold 26 C, step the setpoint down to 24 C and follow it for
+ * an hour. Each run reports the controller's step response (settling
+ * time into +-0.5 C and overshoot) and the temperature swing of the
+ * plant over the last half hour. The PID must settle, overshoot no more
+ * than on/off control and swing less.
+ *
+ * Then the fan is auto-tuned with the PID off: the relay must only
+ * switch the fan enable, the PWM staying at full duty through the run,
+ * when it ends and after TUNE=STOP, so on/off control keeps working.
+ *
+ * The DHT11 reads whole degrees, which limits both controllers alike.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <math.h>
+#include "sim_test.h"
+#include "sim_plant.h"
+#include "adjust_manager.h"
+#include "app_channels.h"
+#include "pwm_emul.h"
+
+#define HOLD_S              8000        /* Heat up to and hold 26 C */
+#define STEP_S              3600        /* Follow the step to 24 C */
+#define SWING_S             1800        /* Swing over the end of the step */
+#define TUNE_S              (AUTOTUNE_TIMEOUT_MS / 1000 + 600)
+#define TUNE_STOP_S         600         /* Into the run stopped by hand */
+
+#define FAN_PWM_DEV         DEVICE_DT_GET(DT_PWMS_CTLR(DT_ALIAS(fan_pwm)))
+#define FAN_PWM_CHANNEL     DT_PWMS_CHANNEL(DT_ALIAS(fan_pwm))
+
+typedef struct {
+    const char *name;
+    int ret;
+    adjust_step_response_t step;
+    float swing;
+} run_result_t;
+
+static void set_temperature(float target)
+{
+    const env_setpoints_t sp = {
+        .target_temperature = target,
+        .target_humidity = 0.0f,        /* Pump and grow light stay off */
+        .target_light = 0.0f,
+    };
+
+    adjust_manager_apply_new_setpoints(&sp, k_cycle_get_32());
+}
+
+static void run(run_result_t *r, bool pid, uint32_t start_s)
+{
+    float lo = INFINITY, hi = -INFINITY;
+
+    sim_test_check(adjust_manager_set_pid_enabled(pid) == 0, "%s selected", r->name);
+    set_temperature(26.0f);
+    sim_test_sleep_until(start_s + HOLD_S);
+
+    set_temperature(24.0f);
+    sim_test_sleep_until(start_s + HOLD_S + STEP_S - SWING_S);
+    for (int s = 0; s < SWING_S; s++) {
+        float t = sim_plant_value(SENSOR_CH_TEMPERATURE);
+
+        lo = MIN(lo, t);
+        hi = MAX(hi, t);
+        k_msleep(1000);
+    }
+    r->swing = hi - lo;
+    r->ret = adjust_manager_get_step_response(&r->step);
+
+    printk("  %-6s settle %u s, overshoot %d mC, swing %.2f C (%.2f to %.2f)\n",
+           r->name, r->step.settle_ms / 1000, r->step.overshoot_mc,
+           (double)r->swing, (double)lo, (double)hi);
+    sim_test_check(r->ret == 0 && r->step.settled && r->step.pid == pid,
+                   "%s: step to 24 C settled (%d)", r->name, r->ret);
+}
+
+static uint32_t fan_duty(void)
+{
+    return pwm_emul_duty_permille(FAN_PWM_DEV, FAN_PWM_CHANNEL);
+}
+
+/* Relay-tunes the fan under on/off control; the duty must stay full */
+static void tune_onoff(void)
+{
+    adjust_autotune_info_t tune;
+    uint32_t min_duty = 1000;
+    bool ran = false;
+    int s;
+
+    sim_test_check(adjust_manager_set_pid_enabled(false) == 0, "on/off selected");
+    set_temperature(26.0f);
+    sim_test_check(adjust_manager_autotune_start(ACTUATOR_FAN) == 0, "fan tune started");
+    for (s = 0; s < TUNE_S; s++) {
+        adjust_manager_get_autotune(&tune);
+        if (tune.state != AUTOTUNE_RUNNING) {
+            break;
+        }
+        min_duty = MIN(min_duty, fan_duty());
+        ran |= (actuator_output_get() & APP_ACTUATOR_FAN) != 0;
+        k_msleep(1000);
+    }
+    printk("  tune   %s after %d s, %d cycles, lowest duty %u\n",
+           autotune_state_name(tune.state), s, tune.cycles, min_duty);
+    sim_test_check(tune.state != AUTOTUNE_RUNNING, "fan tune ended");
+    sim_test_check(ran, "relay switched the fan on");
+    sim_test_check(min_duty == 1000, "duty full during the run (lowest %u)", min_duty);
+    k_msleep(1000);
+    sim_test_check(fan_duty() == 1000, "duty full after the run (%u)", fan_duty());
+
+    sim_test_check(adjust_manager_autotune_start(ACTUATOR_FAN) == 0, "fan tune restarted");
+    k_msleep(TUNE_STOP_S * 1000);
+    adjust_manager_autotune_stop();
+    k_msleep(1000);
+    sim_test_check(fan_duty() == 1000, "duty full after TUNE=STOP (%u)", fan_duty());
+}
+
+static void test_thread(void *p1, void *p2, void *p3)
+{
+    run_result_t onoff = { .name = "on/off" };
+    run_result_t pid = { .name = "PID" };
+    adjust_pid_info_t info;
+
+    adjust_manager_get_pid(&info);
+    sim_test_check(info.available, "fan PWM on the emulator");
+
+    adjust_manager_set_coordinated(false);
+    run(&onoff, false, 0);
+    run(&pid, true, HOLD_S + STEP_S);
+
+    sim_test_check(pid.step.overshoot_mc <= onoff.step.overshoot_mc,
+                   "PID overshoot %d mC, on/off %d mC", pid.step.overshoot_mc,
+                   onoff.step.overshoot_mc);
+    sim_test_check(pid.swing < onoff.swing, "PID swing %.2f C, on/off %.2f C",
+                   (double)pid.swing, (double)onoff.swing);
+
+    tune_onoff();
+
+    sim_test_finish("pid");
+}
+
+void sim_test_start(void)
+{
+    sim_test_spawn(test_thread);
+}
@@ -0,0 +1,148 @@
+/**
+ * @file test_quantile.c
+ * @brief Quantile sketch against exact quantiles (native_sim self-test)
+ *
+ * Feeds a known sample set per channel (normal temperature, bimodal
+ * humidity, log-uniform light) and compares the sketch's percentiles
+ * and fractions with the exact ones from the sorted samples. The error
+ * bound is the width of the bin the exact value falls in.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <stdlib.h>
+#include <math.h>
+#include "sim_test.h"
+#include "quantile_sketch.h"
+
+#define SAMPLES         20000
+#define DAY_MS          (24u * 60u * 60u * 1000u)
+#define TEST_DAY        10u             /* Clear of the boot day */
+
+static const float percentiles[] = { 1.0f, 5.0f, 25.0f, 50.0f, 75.0f, 95.0f, 99.0f };
+
+static float samples[SAMPLES];
+static uint32_t rng = 0x2545F491u;
+
+static float uniform(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return (float)(rng >> 8) / (float)(1u << 24);
+}
+
+/* Approximately normal: sum of four uniforms */
+static float normal(float mean, float sd)
+{
+    float s = uniform() + uniform() + uniform() + uniform() - 2.0f;
+
+    return mean + sd * s * 1.732f;
+}
+
+static float draw(sensor_ch_t ch)
+{
+    switch (ch) {
+    case SENSOR_CH_TEMPERATURE:
+        return normal(22.0f, 3.0f);
+    case SENSOR_CH_HUMIDITY:
+        return (uniform() < 0.5f) ? normal(45.0f, 4.0f) : normal(75.0f, 3.0f);
+    case SENSOR_CH_LIGHT:
+        return expf(logf(10.0f) + uniform() * (logf(20000.0f) - logf(10.0f)));
+    default:
+        return uniform();
+    }
+}
+
+static int cmp_float(const void *a, const void *b)
+{
+    float x = *(const float *)a, y = *(const float *)b;
+
+    return (x > y) - (x < y);
+}
+
+/* Edges of the bin holding 'value', with the sketch's bin mapping */
+static void bin_edges(const sensor_channel_info_t *info, float value, float *lo, float *hi)
+{
+    float r_lo = (float)info->range_min, r_hi = (float)info->range_max;
+    float span = info->log_scale ? log1pf(r_hi - r_lo) : (r_hi - r_lo);
+    float pos = (info->log_scale ? log1pf(value - r_lo) : (value - r_lo)) / span;
+    float i = floorf(CLAMP(pos, 0.0f, 0.9999f) * QUANTILE_BINS);
+
+    if (info->log_scale) {
+        *lo = r_lo + expm1f(i / QUANTILE_BINS * span);
+        *hi = r_lo + expm1f((i + 1.0f) / QUANTILE_BINS * span);
+    } else {
+        *lo = r_lo + i / QUANTILE_BINS * span;
+        *hi = r_lo + (i + 1.0f) / QUANTILE_BINS * span;
+    }
+}
+
+static void check_channel(sensor_ch_t ch)
+{
+    const sensor_channel_info_t *info = sensor_channel_info(ch);
+    uint32_t t0 = TEST_DAY * DAY_MS;
+    float est, lo, hi;
+
+    for (int i = 0; i < SAMPLES; i++) {
+        samples[i] = draw(ch);
+        quantile_sketch_add_sample(ch, samples[i], t0 + (uint32_t)i);
+    }
+    qsort(samples, SAMPLES, sizeof(float), cmp_float);
+
+    for (size_t k = 0; k < ARRAY_SIZE(percentiles); k++) {
+        float p = percentiles[k];
+        int rank = (int)ceilf(p / 100.0f * SAMPLES) - 1;
+        float exact = samples[MAX(rank, 0)];
+        int ret = quantile_sketch_percentile(ch, QUANTILE_DAY_TODAY, p, &est);
+
+        bin_edges(info, exact, &lo, &hi);
+        sim_test_check(ret == 0 && fabsf(est - exact) <= (hi - lo) * 1.01f,
+                       "%s P%.0f: sketch %.2f exact %.2f (bin %.2f)",
+                       info->name, (double)p, (double)est, (double)exact,
+                       (double)(hi - lo));
+    }
+
+    /* Fraction below the exact median: off by at most that bin's share */
+    float median = samples[SAMPLES / 2];
+    int in_bin = 0;
+
+    bin_edges(info, median, &lo, &hi);
+    for (int i = 0; i < SAMPLES; i++) {
+        in_bin += (samples[i] >= lo && samples[i] < hi) ? 1 : 0;
+    }
+    int ret = quantile_sketch_fraction_below(ch, QUANTILE_DAY_TODAY, median, &est);
+
+    sim_test_check(ret == 0 && fabsf(est - 0.5f) <= (float)in_bin / SAMPLES + 0.001f,
+                   "%s below %.2f: sketch %.3f exact 0.500 (bin share %.3f)",
+                   info->name, (double)median, (double)est, (double)in_bin / SAMPLES);
+
+    /* The next day moves today to yesterday, a gap clears both */
+    float before, after;
+
+    quantile_sketch_percentile(ch, QUANTILE_DAY_TODAY, 50.0f, &before);
+    quantile_sketch_add_sample(ch, samples[0], t0 + DAY_MS);
+    ret = quantile_sketch_percentile(ch, QUANTILE_DAY_YESTERDAY, 50.0f, &after);
+    sim_test_check(ret == 0 && after == before, "%s day roll keeps yesterday", info->name);
+
+    quantile_sketch_add_sample(ch, samples[0], t0 + 3 * DAY_MS);
+    ret = quantile_sketch_percentile(ch, QUANTILE_DAY_YESTERDAY, 50.0f, &after);
+    sim_test_check(ret == -ENODATA, "%s gap clears yesterday", info->name);
+}
+
+void sim_test_start(void)
+{
+    printk("Quantile sketch: %u bins, %u bytes for %d channels\n",
+           QUANTILE_BINS, (unsigned int)QUANTILE_SKETCH_RAM_BYTES, SENSOR_CH_COUNT);
+
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        check_channel((sensor_ch_t)ch);
+    }
+
+    /* Two histograms of 16-bit bins plus a few words per channel */
+    sim_test_check(sizeof(quantile_channel_t) <= 4 * QUANTILE_BINS + 32,
+                   "footprint %u bytes per channel", (unsigned int)sizeof(quantile_channel_t));
+
+    quantile_sketch_init();
+    sim_test_finish("quantile");
+}
@@ -0,0 +1,151 @@
+/**
+ * @file test_seqlock.c
+ * @brief Controller state seqlock under contention (native_sim self-test)
+ *
+ * Two threads write setpoints whose three fields always hold the same
+ * value while two readers, one above and one below the writers'
+ * priority, copy the state as fast as they can. A torn read shows up as
+ * fields that differ; the readers also check the generation never goes
+ * back and time every read.
+ *
+ * native_sim runs on one core and only switches threads inside kernel
+ * calls, so this exercises every interleaving the scheduler can produce
+ * but not a writer on another core: read_retries must stay 0 here.
+ * Latency is simulated time, so it shows whether a read ever waits,
+ * not what it costs in cycles.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include "sim_test.h"
+#include "env_controller.h"
+
+#define WRITES_PER_THREAD   2000
+#define STACK_SIZE          1024
+
+typedef struct {
+    const char *name;
+    uint32_t reads;
+    uint32_t torn;
+    uint32_t backwards;
+    uint32_t max_cycles;
+    uint64_t sum_cycles;
+} reader_result_t;
+
+K_THREAD_STACK_ARRAY_DEFINE(stacks, 4, STACK_SIZE);
+static struct k_thread threads[4];
+
+static reader_result_t results[2] = {
+    { .name = "reader above writers" },
+    { .name = "reader below writers" },
+};
+
+static volatile bool writers_done;
+
+static void writer_thread(void *p1, void *p2, void *p3)
+{
+    uint32_t base = (uint32_t)(uintptr_t)p1;
+    env_setpoints_t sp;
+
+    for (uint32_t i = 0; i < WRITES_PER_THREAD; i++) {
+        float v = (float)(base + i % 25);
+
+        sp.target_temperature = v;
+        sp.target_humidity = v;
+        sp.target_light = v;
+        env_controller_set_setpoints(&sp, k_cycle_get_32());
+        k_usleep(50);
+    }
+}
+
+static void reader_thread(void *p1, void *p2, void *p3)
+{
+    reader_result_t *r = p1;
+    bool sleep = (p2 != NULL);
+    uint32_t last_gen = 0;
+    env_state_t s;
+
+    while (!writers_done) {
+        uint32_t start = k_cycle_get_32();
+        uint32_t gen = env_controller_read(&s);
+        uint32_t cycles = k_cycle_get_32() - start;
+
+        r->reads++;
+        r->sum_cycles += cycles;
+        if (cycles > r->max_cycles) {
+            r->max_cycles = cycles;
+        }
+        if (s.setpoints.target_temperature != s.setpoints.target_humidity ||
+            s.setpoints.target_temperature != s.setpoints.target_light) {
+            r->torn++;
+        }
+        if (gen < last_gen) {
+            r->backwards++;
+        }
+        last_gen = gen;
+
+        if (sleep) {
+            k_usleep(37);
+        } else {
+            k_yield();
+        }
+    }
+}
+
+static void start(int i, k_thread_entry_t entry, void *p1, void *p2, int prio)
+{
+    k_thread_create(&threads[i], stacks[i], K_THREAD_STACK_SIZEOF(stacks[i]),
+                    entry, p1, p2, NULL, K_PRIO_PREEMPT(prio), 0, K_NO_WAIT);
+}
+
+void sim_test_start(void)
+{
+    const env_setpoints_t zero = { 0.0f, 0.0f, 0.0f };
+    env_controller_stats_t before, after;
+    uint32_t gen_before;
+
+    env_controller_set_setpoints(&zero, k_cycle_get_32());
+    env_controller_get_stats(&before);
+    gen_before = env_controller_generation();
+
+    start(0, reader_thread, &results[0], (void *)1, 2);
+    start(1, writer_thread, (void *)0, NULL, 4);
+    start(2, writer_thread, (void *)25, NULL, 5);
+    start(3, reader_thread, &results[1], NULL, 7);
+
+    k_thread_join(&threads[1], K_FOREVER);
+    k_thread_join(&threads[2], K_FOREVER);
+    writers_done = true;
+    k_thread_join(&threads[0], K_FOREVER);
+    k_thread_join(&threads[3], K_FOREVER);
+
+    env_controller_get_stats(&after);
+
+    /* The sensor loop is not running yet; the plant may add its mode switch */
+    sim_test_check(after.writes - before.writes >= 2 * WRITES_PER_THREAD,
+                   "writes applied: %u of %u", after.writes - before.writes,
+                   2 * WRITES_PER_THREAD);
+    sim_test_check(env_controller_generation() - gen_before == after.writes - before.writes,
+                   "generation advanced once per write");
+    sim_test_check(after.read_retries == before.read_retries,
+                   "read retries on one core: %u", after.read_retries - before.read_retries);
+
+    for (int i = 0; i < 2; i++) {
+        reader_result_t *r = &results[i];
+        uint32_t avg = r->reads ? (uint32_t)(r->sum_cycles / r->reads) : 0;
+
+        sim_test_check(r->reads > 0 && r->torn == 0 && r->backwards == 0,
+                       "%s: %u reads, %u torn, %u generation steps back",
+                       r->name, r->reads, r->torn, r->backwards);
+        printk("  %s latency: avg %u ns, max %u ns\n", r->name,
+               (uint32_t)k_cyc_to_ns_floor64(avg),
+               (uint32_t)k_cyc_to_ns_floor64(r->max_cycles));
+    }
+
+    /* Nothing may run between the two cycle reads of the higher reader
+     * except the writer, so a read that waited would take a tick */
+    sim_test_check(results[0].max_cycles < k_ticks_to_cyc_floor32(1),
+                   "reader above writers never waited");
+
+    sim_test_finish("seqlock");
+}
@@ -0,0 +1,69 @@
+/**
+ * @file test_stale.c
+ * @brief Actuators drop to off on a stale input (native_sim self-test)
+ *
+ * Runs against the plant with env_stale.txt, where the DHT11 dies for
+ * 20 minutes. Setpoints ask for the fan and the pump all the time; the
+ * pump must switch off once humidity goes stale and come back after
+ * the sensor recovers, while the fan keeps running on the LM35.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include "sim_test.h"
+#include "adjust_manager.h"
+#include "actuator_output.h"
+#include "sensor_manager.h"
+
+#define FAIL_START_S    300
+#define FAIL_END_S      1500
+
+static void check_outputs(const char *when, bool fan, bool pump)
+{
+    uint32_t on = actuator_output_get();
+
+    sim_test_check(((on & BIT(ACTUATOR_FAN)) != 0) == fan &&
+                   ((on & BIT(ACTUATOR_IRRIGATION)) != 0) == pump,
+                   "%s: fan %s pump %s (HUM %s)", when,
+                   (on & BIT(ACTUATOR_FAN)) ? "on" : "off",
+                   (on & BIT(ACTUATOR_IRRIGATION)) ? "on" : "off",
+                   sensor_manager_is_stale(SENSOR_CH_HUMIDITY) ? "stale" : "fresh");
+}
+
+static void test_thread(void *p1, void *p2, void *p3)
+{
+    /* Cold and very humid targets: fan and pump always wanted */
+    const env_setpoints_t sp = {
+        .target_temperature = 5.0f,
+        .target_humidity = 95.0f,
+        .target_light = 0.0f,
+    };
+    adjust_counters_t c;
+
+    adjust_manager_set_irrigation_tp(false);
+    adjust_manager_apply_new_setpoints(&sp, k_cycle_get_32());
+
+    sim_test_sleep_until(FAIL_START_S - 30);
+    check_outputs("before the failure", true, true);
+
+    /* Stale SENSOR_STALE_MS after the last good sample, plus a cycle */
+    sim_test_sleep_until(FAIL_START_S + SENSOR_STALE_MS / 1000 + 5);
+    check_outputs("humidity stale", true, false);
+
+    sim_test_sleep_until(FAIL_END_S - 10);
+    check_outputs("end of the failure", true, false);
+
+    adjust_manager_get_counters(ACTUATOR_IRRIGATION, &c);
+    sim_test_check(c.stale_off == 1, "pump forced off %u time(s)", c.stale_off);
+
+    /* Recovery probe (breaker open) plus the pump's minimum off-time */
+    sim_test_sleep_until(FAIL_END_S + SENSOR_PROBE_INTERVAL_MS / 1000 + 30);
+    check_outputs("after recovery", true, true);
+
+    sim_test_finish("stale");
+}
+
+void sim_test_start(void)
+{
+    sim_test_spawn(test_thread);
+}
@@ -0,0 +1,83 @@
+/**
+ * @file test_trend.c
+ * @brief Trend regression and feed-forward overshoot (native_sim self-test)
+ *
+ * First the regression on its own: a ramp of known slope whose sample
+ * times cross the 32-bit millisecond wrap must give that slope and its
+ * forecast. Then closed loop against env_ff.txt, where the sun heats
+ * the house in hourly ramps: PHASE_S with feed-forward, then PHASE_S
+ * without. The controller accounts the excursions above the target per
+ * mode; feed-forward must spend less time above the target plus the
+ * fan deadband and peak no higher. It runs first, so the warm-up counts
+ * against it.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/printk.h>
+#include <math.h>
+#include "sim_test.h"
+#include "trend.h"
+#include "adjust_manager.h"
+
+#define RAMP_PER_MIN        0.5f        /* C per minute */
+#define RAMP_START_MS       (UINT32_MAX - 60000U)
+#define PHASE_S             (5 * 3600)
+
+static void test_wrap(void)
+{
+    sensor_data_t d = { 0 };
+    trend_info_t t;
+    int ret;
+
+    trend_init();
+    for (int i = 0; i < TREND_WINDOW; i++) {
+        d.timestamp = RAMP_START_MS + (uint32_t)i * 1000U;     /* Wraps at i = 60 */
+        d.value[SENSOR_CH_TEMPERATURE] = 20.0f + RAMP_PER_MIN * i / 60.0f;
+        d.valid[SENSOR_CH_TEMPERATURE] = true;
+        trend_add_data(&d);
+    }
+
+    ret = trend_get(SENSOR_CH_TEMPERATURE, 60, &t);
+    printk("  across the wrap: slope %.3f C/min, forecast %.2f C\n",
+           (double)t.slope_per_min, (double)t.forecast);
+    sim_test_check(ret == 0 && fabsf(t.slope_per_min - RAMP_PER_MIN) < 0.01f,
+                   "slope across the 32-bit wrap");
+    sim_test_check(ret == 0 && fabsf(t.forecast - (t.value + RAMP_PER_MIN)) < 0.01f,
+                   "forecast one minute ahead");
+
+    /* The sensor cycle starts from a clean slate */
+    trend_init();
+}
+
+static void test_thread(void *p1, void *p2, void *p3)
+{
+    const env_setpoints_t sp = {
+        .target_temperature = 24.0f,
+        .target_humidity = 0.0f,        /* Pump and grow light stay off */
+        .target_light = 0.0f,
+    };
+    adjust_ff_info_t ff;
+
+    adjust_manager_apply_new_setpoints(&sp, k_cycle_get_32());
+    adjust_manager_set_feed_forward(true);
+    sim_test_sleep_until(PHASE_S);
+    adjust_manager_set_feed_forward(false);
+    sim_test_sleep_until(2 * PHASE_S);
+    adjust_manager_get_feed_forward(&ff);
+
+    for (int m = 1; m >= 0; m--) {
+        printk("  feed-forward %-3s %u s run, %u s above target, peak +%.1f C\n",
+               m ? "on" : "off", ff.run_s[m], ff.over_s[m], (double)ff.over_max[m]);
+    }
+    sim_test_check(ff.run_s[0] > 0 && ff.run_s[1] > 0, "both modes ran");
+    sim_test_check(ff.over_s[1] < ff.over_s[0], "less time above target with feed-forward");
+    sim_test_check(ff.over_max[1] <= ff.over_max[0], "peak no higher with feed-forward");
+
+    sim_test_finish("trend");
+}
+
+void sim_test_start(void)
+{
+    test_wrap();
+    sim_test_spawn(test_thread);
+}
@@ -0,0 +1,126 @@
+/**
+ * @file trace_replay.c
+ * @brief Replay of a recorded trace through the application (native_sim)
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/printk.h>
+#include <string.h>
+#include <posix_board_if.h>
+#include "trace_replay.h"
+#include "trace.h"
+#include "env_controller.h"
+#include "actuator_output.h"
+#include "uart_bt.h"
+
+LOG_MODULE_REGISTER(trace_replay, LOG_LEVEL_INF);
+
+#define FNV_OFFSET  2166136261u
+#define FNV_PRIME   16777619u
+
+/* Trace bytes, generated from SIM_REPLAY_TRACE at build time */
+static const uint8_t trace_data[] = {
+#include "sim_replay_trace.inc"
+};
+
+static trace_reader_t reader;
+static bool started;
+static uint32_t trace_t0;           /* Recorder time of the first record */
+static int64_t replay_t0;           /* Uptime the replay started at */
+static uint32_t samples, commands;
+static uint32_t digest = FNV_OFFSET;
+
+static void digest_add(const void *bytes, size_t len)
+{
+    const uint8_t *p = bytes;
+
+    for (size_t i = 0; i < len; i++) {
+        digest = (digest ^ p[i]) * FNV_PRIME;
+    }
+}
+
+/* Folds in what the application made of the previous sample. Fields
+ * one by one: no padding bytes in the digest. */
+static void digest_outputs(void)
+{
+    env_state_t st;
+    uint32_t mode, outputs = actuator_output_get();
+
+    env_controller_read(&st);
+    mode = st.mode;
+    digest_add(&mode, sizeof(mode));
+    digest_add(&st.measurements.temperature, sizeof(float));
+    digest_add(&st.measurements.humidity, sizeof(float));
+    digest_add(&st.measurements.light, sizeof(float));
+    digest_add(&st.setpoints.target_temperature, sizeof(float));
+    digest_add(&st.setpoints.target_humidity, sizeof(float));
+    digest_add(&st.setpoints.target_light, sizeof(float));
+    digest_add(&outputs, sizeof(outputs));
+}
+
+/* Sleeps until recorder time 't' maps to now */
+static void wait_until(uint32_t t)
+{
+    int64_t due = replay_t0 + (t - trace_t0);
+    int64_t now = k_uptime_get();
+
+    if (due > now) {
+        k_msleep((int32_t)(due - now));
+    }
+}
+
+static void finish(int rc)
+{
+    uint32_t expected = CONFIG_GREENHOUSE_REPLAY_DIGEST;
+    bool mismatch = (expected != 0 && digest != expected);
+
+    if (rc == -EBADMSG) {
+        LOG_ERR("Trace corrupt at byte %u", (unsigned int)reader.pos);
+    }
+    printk("Replay: %u samples, %u commands, %u ms, digest 0x%08x%s\n",
+           samples, commands, (unsigned int)(k_uptime_get() - replay_t0), digest,
+           (expected == 0) ? "" : (mismatch ? " MISMATCH" : " OK"));
+    posix_exit((mismatch || rc == -EBADMSG) ? 1 : 0);
+}
+
+int trace_replay_next(sensor_data_t *data)
+{
+    trace_rec_t rec;
+    int rc;
+
+    if (!started) {
+        rc = trace_reader_init(&reader, trace_data, sizeof(trace_data));
+        if (rc != 0) {
+            LOG_ERR("Not a trace for this build (%u bytes)", (unsigned int)sizeof(trace_data));
+            posix_exit(1);
+        }
+        /* A replayed trace is not recorded again */
+        trace_enable(false);
+        trace_t0 = reader.time_ms;
+        replay_t0 = k_uptime_get();
+        started = true;
+        LOG_INF("Replaying %u bytes of trace", (unsigned int)sizeof(trace_data));
+    } else {
+        digest_outputs();
+    }
+
+    while ((rc = trace_reader_next(&reader, &rec)) == 0) {
+        wait_until(rec.time_ms);
+
+        if (rec.type == TRACE_REC_COMMAND) {
+            uart_bt_inject(rec.command);
+            commands++;
+            continue;
+        }
+
+        *data = rec.sample;
+        data->timestamp = (uint32_t)k_uptime_get();
+        digest_add(data->value, sizeof(data->value));
+        samples++;
+        return 0;
+    }
+
+    finish(rc);
+    return rc;
+}
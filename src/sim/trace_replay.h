@@ -0,0 +1,35 @@
+/**
+ * @file trace_replay.h
+ * @brief Replay of a recorded trace through the application (native_sim)
+ *
+ * The trace is compiled in from SIM_REPLAY_TRACE (CMake cache variable,
+ * a binary trace as described in trace.h). With CONFIG_GREENHOUSE_REPLAY
+ * the sensor cycle takes its samples from the trace instead of the
+ * sensors, and recorded commands are queued to the Bluetooth handler at
+ * their recorded times. Simulated time follows the recorded timestamps
+ * and runs as fast as the host allows.
+ *
+ * Samples enter after the sensor manager: its fetches, fallback order,
+ * health backoff and circuit breaker are not run again. What they made
+ * of the readings is in the trace already, as the valid mask of each
+ * sample, and main.c ages the replayed channels for the stale flags
+ * from the sample times.
+ *
+ * After each sample the resulting mode, measurements, setpoints and
+ * actuator outputs are folded into a digest. At the end of the trace the
+ * digest is printed and zephyr.exe exits, with status 1 if it differs
+ * from CONFIG_GREENHOUSE_REPLAY_DIGEST (when that is set), so a replay
+ * is a regression test.
+ */
+
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include "sensor_manager.h"
+
+/* Waits until the next recorded sample is due, queues the commands
+ * recorded before it and fills 'data'. Does not return at the end of
+ * the trace. */
+int trace_replay_next(sensor_data_t *data);
+
+#endif /* TRACE_REPLAY_H */
@@ -0,0 +1,177 @@
+/**
+ * @file stats_rollup.c
+ * @brief Cascading minute/hour/day aggregates per sensor channel
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+#include "stats_rollup.h"
+
+#define MS_PER_MINUTE   60000u
+#define MS_PER_HOUR     (60u * MS_PER_MINUTE)
+#define MS_PER_DAY      (24u * MS_PER_HOUR)
+
+/* One aggregate bucket. 'epoch' is timestamp / period and tags which
+ * minute/hour/day the slot currently holds. */
+typedef struct {
+    uint32_t epoch;
+    uint32_t count;
+    float min;
+    float max;
+    float mean;
+    float m2;           /* Sum of squared deviations (Welford) */
+} stats_bucket_t;
+
+typedef struct {
+    stats_bucket_t minute[STATS_MINUTE_BUCKETS];
+    stats_bucket_t hour[STATS_HOUR_BUCKETS];
+    stats_bucket_t day[STATS_DAY_BUCKETS];
+} stats_channel_t;
+
+static stats_channel_t channels[SENSOR_CH_COUNT];
+K_MUTEX_DEFINE(stats_lock);
+
+/* Adds a sample to the bucket of 'epoch', recycling the slot if it is stale */
+static void bucket_add(stats_bucket_t *ring, uint32_t size, uint32_t epoch, float value)
+{
+    stats_bucket_t *b = &ring[epoch % size];
+
+    if (b->count == 0 || b->epoch != epoch) {
+        b->epoch = epoch;
+        b->count = 1;
+        b->min = value;
+        b->max = value;
+        b->mean = value;
+        b->m2 = 0.0f;
+        return;
+    }
+
+    b->count++;
+    if (value < b->min) b->min = value;
+    if (value > b->max) b->max = value;
+
+    float delta = value - b->mean;
+    b->mean += delta / (float)b->count;
+    b->m2 += delta * (value - b->mean);
+}
+
+/* Merges bucket b into accumulator a (Chan et al. parallel variance) */
+static void bucket_merge(stats_bucket_t *a, const stats_bucket_t *b)
+{
+    if (b->count == 0) return;
+
+    if (a->count == 0) {
+        *a = *b;
+        return;
+    }
+
+    uint32_t n = a->count + b->count;
+    float delta = b->mean - a->mean;
+
+    a->mean += delta * (float)b->count / (float)n;
+    a->m2 += b->m2 + delta * delta * (float)a->count * (float)b->count / (float)n;
+    if (b->min < a->min) a->min = b->min;
+    if (b->max > a->max) a->max = b->max;
+    a->count = n;
+}
+
+/* Merges the last 'span' epochs (ending at now_epoch) of a ring */
+static void ring_merge(stats_bucket_t *acc, const stats_bucket_t *ring, uint32_t size,
+                       uint32_t now_epoch, uint32_t span)
+{
+    for (uint32_t i = 0; i < size; i++) {
+        const stats_bucket_t *b = &ring[i];
+
+        if (b->count > 0 && b->epoch <= now_epoch && (now_epoch - b->epoch) < span) {
+            bucket_merge(acc, b);
+        }
+    }
+}
+
+void stats_rollup_init(void)
+{
+    k_mutex_lock(&stats_lock, K_FOREVER);
+    memset(channels, 0, sizeof(channels));
+    k_mutex_unlock(&stats_lock);
+}
+
+void stats_rollup_add_sample(sensor_ch_t ch, float value, uint32_t timestamp_ms)
+{
+    if (ch >= SENSOR_CH_COUNT || value != value) { /* Reject NaN */
+        return;
+    }
+
+    stats_channel_t *c = &channels[ch];
+
+    k_mutex_lock(&stats_lock, K_FOREVER);
+    bucket_add(c->minute, STATS_MINUTE_BUCKETS, timestamp_ms / MS_PER_MINUTE, value);
+    bucket_add(c->hour, STATS_HOUR_BUCKETS, timestamp_ms / MS_PER_HOUR, value);
+    bucket_add(c->day, STATS_DAY_BUCKETS, timestamp_ms / MS_PER_DAY, value);
+    k_mutex_unlock(&stats_lock);
+}
+
+void stats_rollup_add_data(const sensor_data_t *data)
+{
+    float value;
+
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        if (sensor_data_get_channel(data, (sensor_ch_t)ch, &value)) {
+            stats_rollup_add_sample((sensor_ch_t)ch, value, data->timestamp);
+        }
+    }
+}
+
+int stats_rollup_get(sensor_ch_t ch, stats_window_t win, stats_summary_t *out)
+{
+    stats_bucket_t acc = {0};
+    uint32_t now = k_uptime_get_32();
+
+    if (ch >= SENSOR_CH_COUNT || win >= STATS_WIN_COUNT || !out) {
+        return -EINVAL;
+    }
+
+    const stats_channel_t *c = &channels[ch];
+
+    k_mutex_lock(&stats_lock, K_FOREVER);
+    switch (win) {
+    case STATS_WIN_THIS_MINUTE:
+        ring_merge(&acc, c->minute, STATS_MINUTE_BUCKETS, now / MS_PER_MINUTE, 1);
+        break;
+    case STATS_WIN_HOUR:
+        ring_merge(&acc, c->minute, STATS_MINUTE_BUCKETS, now / MS_PER_MINUTE,
+                   STATS_MINUTE_BUCKETS);
+        break;
+    case STATS_WIN_DAY:
+        ring_merge(&acc, c->hour, STATS_HOUR_BUCKETS, now / MS_PER_HOUR,
+                   STATS_HOUR_BUCKETS);
+        break;
+    default:
+        ring_merge(&acc, c->day, STATS_DAY_BUCKETS, now / MS_PER_DAY,
+                   STATS_DAY_BUCKETS);
+        break;
+    }
+    k_mutex_unlock(&stats_lock);
+
+    if (acc.count == 0) {
+        return -ENODATA;
+    }
+
+    out->count = acc.count;
+    out->min = acc.min;
+    out->max = acc.max;
+    out->mean = acc.mean;
+    out->variance = acc.m2 / (float)acc.count;
+    return 0;
+}
+
+const char* stats_window_name(stats_window_t win)
+{
+    static const char *const names[STATS_WIN_COUNT] = {
+        [STATS_WIN_THIS_MINUTE] = "1m",
+        [STATS_WIN_HOUR]   = "1h",
+        [STATS_WIN_DAY]    = "24h",
+        [STATS_WIN_WEEK]   = "7d",
+    };
+
+    return (win < STATS_WIN_COUNT) ? names[win] : "?";
+}
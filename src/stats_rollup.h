@@ -0,0 +1,56 @@
+/**
+ * @file stats_rollup.h
+ * @brief Incremental per-channel min/max/mean/variance aggregates
+ *
+ * Every sample updates the current minute, hour and day bucket of its
+ * channel in O(1) (Welford). Older buckets are kept in small rings so
+ * rolling windows are answered by merging buckets, never raw samples.
+ */
+
+#ifndef STATS_ROLLUP_H
+#define STATS_ROLLUP_H
+
+#include <stdint.h>
+#include "sensor_manager.h"
+
+/* History depth of each bucket level */
+#define STATS_MINUTE_BUCKETS  60
+#define STATS_HOUR_BUCKETS    24
+#define STATS_DAY_BUCKETS     7
+
+/* Query windows. Hour, day and week are rolling, ending at the latest
+ * sample; the minute window is the current calendar minute only (0 to
+ * 60 s of samples), not the last 60 s. */
+typedef enum {
+    STATS_WIN_THIS_MINUTE = 0,  /* Current minute bucket */
+    STATS_WIN_HOUR,             /* Last 60 minute buckets */
+    STATS_WIN_DAY,              /* Last 24 hour buckets */
+    STATS_WIN_WEEK,             /* Last 7 day buckets */
+    STATS_WIN_COUNT
+} stats_window_t;
+
+/* Query result */
+typedef struct {
+    uint32_t count;
+    float min;
+    float max;
+    float mean;
+    float variance;     /* Population variance */
+} stats_summary_t;
+
+/* Clears all buckets */
+void stats_rollup_init(void);
+
+/* Adds one sample (timestamp from k_uptime_get_32) */
+void stats_rollup_add_sample(sensor_ch_t ch, float value, uint32_t timestamp_ms);
+
+/* Adds every valid channel of a sensor snapshot */
+void stats_rollup_add_data(const sensor_data_t *data);
+
+/* Fills out; returns 0, -EINVAL on bad args or -ENODATA if the window is empty */
+int stats_rollup_get(sensor_ch_t ch, stats_window_t win, stats_summary_t *out);
+
+/* Short window name ("1m", "1h", "24h", "7d") */
+const char* stats_window_name(stats_window_t win);
+
+#endif /* STATS_ROLLUP_H */
@@ -0,0 +1,325 @@
+/**
+ * @file trace.c
+ * @brief Recorder of sensor samples and Bluetooth commands (binary trace)
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/sys/util.h>
+#include <zephyr/sys/byteorder.h>
+#include <stdio.h>
+#include <string.h>
+#include "trace.h"
+
+#define TAG_SAMPLE      0x40
+#define TAG_COMMAND     0x80
+#define TAG_TYPE_MASK   0xC0
+#define VARINT_MAX      5
+#define RECORD_MAX      (1 + VARINT_MAX + 1 + TRACE_CMD_MAX)
+#define DUMP_BYTES      32          /* Trace bytes per hex line */
+
+/* The valid mask shares the tag byte */
+BUILD_ASSERT(SENSOR_CH_COUNT <= 6, "trace sample tag holds 6 channels");
+BUILD_ASSERT(CONFIG_GREENHOUSE_TRACE_SIZE >= 2 * RECORD_MAX, "trace ring too small");
+
+K_MUTEX_DEFINE(trace_lock);
+
+/* Ring of whole records, oldest at 'tail' (under trace_lock) */
+static uint8_t ring[CONFIG_GREENHOUSE_TRACE_SIZE];
+static uint32_t tail, used;
+static uint32_t tail_ms;            /* Time of the oldest record */
+static uint32_t last_ms;            /* Time of the newest record */
+static uint32_t records, dropped;
+static bool enabled = true;
+
+static size_t put_varint(uint8_t *p, uint32_t v)
+{
+    size_t n = 0;
+
+    do {
+        p[n] = (v & 0x7F) | ((v > 0x7F) ? 0x80 : 0);
+        v >>= 7;
+        n++;
+    } while (v);
+    return n;
+}
+
+/* Reads a varint through 'get'; returns its length, 0 if malformed */
+static size_t get_varint(uint8_t (*get)(const void *ctx, size_t i), const void *ctx,
+                         size_t at, size_t avail, uint32_t *v)
+{
+    *v = 0;
+    for (size_t n = 0; n < VARINT_MAX && at + n < avail; n++) {
+        uint8_t b = get(ctx, at + n);
+
+        *v |= (uint32_t)(b & 0x7F) << (7 * n);
+        if ((b & 0x80) == 0) {
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+/* Record length from its first bytes, 0 if malformed */
+static size_t record_len(uint8_t (*get)(const void *ctx, size_t i), const void *ctx,
+                         size_t avail, uint32_t *dt)
+{
+    if (avail < 1) {
+        return 0;
+    }
+
+    uint8_t tag = get(ctx, 0);
+    size_t n = get_varint(get, ctx, 1, avail, dt);
+
+    if (n == 0) {
+        return 0;
+    }
+    n += 1;
+
+    switch (tag & TAG_TYPE_MASK) {
+    case TAG_SAMPLE:
+        return n + 4 * __builtin_popcount(tag & ~TAG_TYPE_MASK);
+    case TAG_COMMAND:
+        return (n < avail) ? n + 1 + get(ctx, n) : 0;
+    default:
+        return 0;
+    }
+}
+
+static uint8_t ring_get(const void *ctx, size_t i)
+{
+    ARG_UNUSED(ctx);
+    return ring[(tail + i) % sizeof(ring)];
+}
+
+static uint8_t buf_get(const void *ctx, size_t i)
+{
+    return ((const uint8_t *)ctx)[i];
+}
+
+/* Drops the oldest record; the next one becomes the time base */
+static void drop_oldest(void)
+{
+    uint32_t dt;
+    size_t len = record_len(ring_get, NULL, used, &dt);
+
+    tail = (tail + len) % sizeof(ring);
+    used -= len;
+    records--;
+    dropped++;
+
+    if (used > 0 && record_len(ring_get, NULL, used, &dt) > 0) {
+        tail_ms += dt;
+    }
+}
+
+static void append(uint8_t tag, uint32_t now, const uint8_t *payload, size_t len)
+{
+    uint8_t rec[RECORD_MAX];
+    size_t n;
+
+    k_mutex_lock(&trace_lock, K_FOREVER);
+
+    if (!enabled) {
+        k_mutex_unlock(&trace_lock);
+        return;
+    }
+
+    if (used == 0) {
+        tail_ms = now;
+        last_ms = now;
+    }
+
+    rec[0] = tag;
+    n = 1 + put_varint(&rec[1], now - last_ms);
+    memcpy(&rec[n], payload, len);
+    n += len;
+
+    while (sizeof(ring) - used < n) {
+        drop_oldest();
+    }
+    if (used == 0) {
+        tail_ms = now;
+    }
+
+    uint32_t head = (tail + used) % sizeof(ring);
+    size_t first = MIN(n, sizeof(ring) - head);
+
+    memcpy(&ring[head], rec, first);
+    memcpy(ring, &rec[first], n - first);
+    used += n;
+    records++;
+    last_ms = now;
+
+    k_mutex_unlock(&trace_lock);
+}
+
+void trace_record_sample(const sensor_data_t *data)
+{
+    uint8_t payload[4 * SENSOR_CH_COUNT];
+    uint8_t mask = 0;
+    size_t len = 0;
+
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        if (data->valid[ch]) {
+            mask |= BIT(ch);
+            memcpy(&payload[len], &data->value[ch], 4);
+            len += 4;
+        }
+    }
+    append(TAG_SAMPLE | mask, k_uptime_get_32(), payload, len);
+}
+
+void trace_record_command(const char *line)
+{
+    uint8_t payload[1 + TRACE_CMD_MAX];
+    size_t len = strnlen(line, TRACE_CMD_MAX - 1);
+
+    payload[0] = (uint8_t)len;
+    memcpy(&payload[1], line, len);
+    append(TAG_COMMAND, k_uptime_get_32(), payload, 1 + len);
+}
+
+void trace_enable(bool enable)
+{
+    k_mutex_lock(&trace_lock, K_FOREVER);
+    enabled = enable;
+    k_mutex_unlock(&trace_lock);
+}
+
+void trace_clear(void)
+{
+    k_mutex_lock(&trace_lock, K_FOREVER);
+    tail = used = 0;
+    records = dropped = 0;
+    k_mutex_unlock(&trace_lock);
+}
+
+void trace_get_info(trace_info_t *out)
+{
+    k_mutex_lock(&trace_lock, K_FOREVER);
+    out->enabled = enabled;
+    out->bytes = used;
+    out->capacity = sizeof(ring);
+    out->records = records;
+    out->dropped = dropped;
+    out->span_ms = (used > 0) ? last_ms - tail_ms : 0;
+    k_mutex_unlock(&trace_lock);
+}
+
+static void hex_append(char *line, size_t *pos, const uint8_t *bytes, size_t n)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    for (size_t i = 0; i < n; i++) {
+        line[(*pos)++] = digits[bytes[i] >> 4];
+        line[(*pos)++] = digits[bytes[i] & 0x0F];
+    }
+}
+
+void trace_dump(void (*emit)(const char *line))
+{
+    uint8_t header[TRACE_HEADER_SIZE] = {
+        'G', 'H', 'T', TRACE_VERSION, SENSOR_CH_COUNT,
+    };
+    char line[4 + 2 * DUMP_BYTES + 3];
+    size_t pos;
+    uint32_t bytes;
+    bool was_enabled;
+
+    /* Appends are skipped while paused, so the ring stays still without
+     * holding the lock through a slow UART transfer */
+    k_mutex_lock(&trace_lock, K_FOREVER);
+    was_enabled = enabled;
+    enabled = false;
+    bytes = used;
+    sys_put_le32(tail_ms, &header[5]);
+    k_mutex_unlock(&trace_lock);
+
+    snprintf(line, sizeof(line), "TRACE BEGIN %u\r\n", (unsigned int)(sizeof(header) + bytes));
+    emit(line);
+
+    memcpy(line, "TRC:", 4);
+    pos = 4;
+    hex_append(line, &pos, header, sizeof(header));
+
+    for (uint32_t i = 0; i < bytes; i++) {
+        uint8_t b = ring_get(NULL, i);
+
+        hex_append(line, &pos, &b, 1);
+        if (pos == sizeof(line) - 3) {
+            strcpy(&line[pos], "\r\n");
+            emit(line);
+            pos = 4;
+        }
+    }
+    if (pos > 4) {
+        strcpy(&line[pos], "\r\n");
+        emit(line);
+    }
+    emit("TRACE END\r\n");
+
+    trace_enable(was_enabled);
+}
+
+int trace_reader_init(trace_reader_t *r, const uint8_t *data, size_t len)
+{
+    if (len < TRACE_HEADER_SIZE || memcmp(data, "GHT", 3) != 0 ||
+        data[3] != TRACE_VERSION || data[4] != SENSOR_CH_COUNT) {
+        return -EBADMSG;
+    }
+
+    r->data = data;
+    r->len = len;
+    r->pos = TRACE_HEADER_SIZE;
+    r->time_ms = sys_get_le32(&data[5]);
+    r->first = true;
+    return 0;
+}
+
+int trace_reader_next(trace_reader_t *r, trace_rec_t *out)
+{
+    const uint8_t *p = &r->data[r->pos];
+    size_t avail = r->len - r->pos;
+    uint32_t dt;
+
+    if (avail == 0) {
+        return -ENODATA;
+    }
+
+    size_t len = record_len(buf_get, p, avail, &dt);
+
+    if (len == 0 || len > avail) {
+        return -EBADMSG;
+    }
+
+    if (!r->first) {
+        r->time_ms += dt;
+    }
+    r->first = false;
+    out->time_ms = r->time_ms;
+
+    /* The payload follows the tag and the varint */
+    size_t at = 1 + get_varint(buf_get, p, 1, avail, &dt);
+
+    if ((p[0] & TAG_TYPE_MASK) == TAG_SAMPLE) {
+        out->type = TRACE_REC_SAMPLE;
+        memset(&out->sample, 0, sizeof(out->sample));
+        for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+            if (p[0] & BIT(ch)) {
+                out->sample.valid[ch] = true;
+                memcpy(&out->sample.value[ch], &p[at], 4);
+                at += 4;
+            }
+        }
+        out->sample.timestamp = r->time_ms;
+    } else {
+        size_t n = MIN(p[at], TRACE_CMD_MAX - 1);
+
+        out->type = TRACE_REC_COMMAND;
+        memcpy(out->command, &p[at + 1], n);
+        out->command[n] = '\0';
+    }
+
+    r->pos += len;
+    return 0;
+}
@@ -0,0 +1,86 @@
+/**
+ * @file trace.h
+ * @brief Recorder of sensor samples and Bluetooth commands (binary trace)
+ *
+ * Every raw sample of the sensor cycle and every command line is
+ * appended to a RAM ring of CONFIG_GREENHOUSE_TRACE_SIZE bytes. When it
+ * is full the oldest records are dropped, so the ring holds the last
+ * minutes before a problem. TRACE=DUMP sends it as hex lines that
+ * turn back into the binary trace with
+ *
+ *   grep '^TRC:' bt_log.txt | cut -c5- | xxd -r -p > trace.bin
+ *
+ * and the native_sim replay (src/sim/trace_replay.h) feeds that file
+ * back through the application.
+ *
+ * Format, little endian:
+ *   header   "GHT" version(1) channels(1) base_ms(4)
+ *   record   tag(1) dt_ms(LEB128) payload
+ *     sample   tag = 0x40 | valid mask; a float32 per valid channel
+ *     command  tag = 0x80; length(1) and the text, no NUL
+ * dt_ms is the time since the previous record; the first record is at
+ * base_ms. Values are stored bit for bit, so a replay sees exactly
+ * what the recorder saw.
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "sensor_manager.h"
+
+#define TRACE_VERSION       1
+#define TRACE_HEADER_SIZE   9
+#define TRACE_CMD_MAX       64      /* Command text, NUL included */
+
+typedef enum {
+    TRACE_REC_SAMPLE = 1,
+    TRACE_REC_COMMAND,
+} trace_rec_type_t;
+
+typedef struct {
+    trace_rec_type_t type;
+    uint32_t time_ms;               /* Recorder uptime */
+    sensor_data_t sample;           /* TRACE_REC_SAMPLE, timestamp = time_ms */
+    char command[TRACE_CMD_MAX];    /* TRACE_REC_COMMAND */
+} trace_rec_t;
+
+typedef struct {
+    bool enabled;
+    uint32_t bytes;                 /* Held in the ring */
+    uint32_t capacity;
+    uint32_t records;
+    uint32_t dropped;               /* Oldest records overwritten */
+    uint32_t span_ms;               /* Oldest to newest record */
+} trace_info_t;
+
+/* Recording (thread context, serialized internally) */
+void trace_record_sample(const sensor_data_t *data);
+void trace_record_command(const char *line);
+
+void trace_enable(bool enable);
+void trace_clear(void);
+void trace_get_info(trace_info_t *out);
+
+/* Sends the ring as "TRC:" hex lines through 'emit', framed by a
+ * TRACE BEGIN / TRACE END line; recording pauses meanwhile */
+void trace_dump(void (*emit)(const char *line));
+
+/* Reading a trace back */
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+    uint32_t time_ms;
+    bool first;
+} trace_reader_t;
+
+/* 0, or -EBADMSG if the header is not a trace for this channel set */
+int trace_reader_init(trace_reader_t *r, const uint8_t *data, size_t len);
+
+/* 0, -ENODATA at the end or -EBADMSG on a truncated/corrupt record */
+int trace_reader_next(trace_reader_t *r, trace_rec_t *out);
+
+#endif /* TRACE_H */
@@ -0,0 +1,163 @@
+/**
+ * @file trend.c
+ * @brief Sliding-window linear regression per channel (slope, forecast)
+ */
+
+#include <zephyr/kernel.h>
+#include <string.h>
+#include "trend.h"
+
+/* Times are kept relative to an origin; past this the origin moves to
+ * the oldest sample and the sums are rebuilt (every few hours) */
+#define REBASE_MS           10000000
+
+typedef struct {
+    uint32_t t[TREND_WINDOW];   /* Sample time, ms since boot */
+    int32_t y[TREND_WINDOW];    /* Value, milli-units */
+    uint32_t head;              /* Next slot to write */
+    uint32_t count;
+    uint32_t origin_ms;
+    int64_t sx, sxx, sy, sxy;   /* Sums over the window, x = rel_ms(t) */
+} trend_channel_t;
+
+/* Slope under which a channel counts as steady, per minute */
+static const float steady_per_min[SENSOR_CH_COUNT] = {
+    [SENSOR_CH_TEMPERATURE] = 0.05f,    /* 3 C per hour */
+    [SENSOR_CH_HUMIDITY]    = 0.2f,
+    [SENSOR_CH_LIGHT]       = 50.0f,
+};
+
+static trend_channel_t channels[SENSOR_CH_COUNT];
+
+K_MUTEX_DEFINE(trend_lock);
+
+/* Sample time relative to the origin. Every sample in the window is at
+ * or after it, so the unsigned difference stays right when the 32-bit
+ * millisecond clock wraps (every 49.7 days) between the two. */
+static inline int64_t rel_ms(const trend_channel_t *c, uint32_t t)
+{
+    return (int64_t)(uint32_t)(t - c->origin_ms);
+}
+
+static void sums_add(trend_channel_t *c, uint32_t t, int32_t y, int sign)
+{
+    int64_t x = rel_ms(c, t);
+
+    c->sx += sign * x;
+    c->sxx += sign * x * x;
+    c->sy += sign * (int64_t)y;
+    c->sxy += sign * x * y;
+}
+
+/* Moves the origin to the oldest sample and recomputes the sums */
+static void rebase(trend_channel_t *c)
+{
+    uint32_t oldest = (c->head + TREND_WINDOW - c->count) % TREND_WINDOW;
+
+    c->origin_ms = c->t[oldest];
+    c->sx = c->sxx = c->sy = c->sxy = 0;
+    for (uint32_t i = 0; i < c->count; i++) {
+        uint32_t k = (oldest + i) % TREND_WINDOW;
+        sums_add(c, c->t[k], c->y[k], 1);
+    }
+}
+
+static void trend_add_sample(sensor_ch_t ch, float value, uint32_t timestamp_ms)
+{
+    trend_channel_t *c = &channels[ch];
+    int32_t y = (int32_t)(value * 1000.0f);
+
+    k_mutex_lock(&trend_lock, K_FOREVER);
+
+    if (c->count == 0) {
+        c->origin_ms = timestamp_ms;
+    }
+    if (c->count == TREND_WINDOW) {
+        /* The slot about to be reused holds the oldest sample */
+        sums_add(c, c->t[c->head], c->y[c->head], -1);
+        c->count--;
+    }
+
+    c->t[c->head] = timestamp_ms;
+    c->y[c->head] = y;
+    c->head = (c->head + 1) % TREND_WINDOW;
+    c->count++;
+    sums_add(c, timestamp_ms, y, 1);
+
+    if (timestamp_ms - c->origin_ms > REBASE_MS) {
+        rebase(c);
+    }
+
+    k_mutex_unlock(&trend_lock);
+}
+
+void trend_init(void)
+{
+    k_mutex_lock(&trend_lock, K_FOREVER);
+    memset(channels, 0, sizeof(channels));
+    k_mutex_unlock(&trend_lock);
+}
+
+void trend_add_data(const sensor_data_t *data)
+{
+    float value;
+
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        if (sensor_data_get_channel(data, (sensor_ch_t)ch, &value) && value == value) {
+            trend_add_sample((sensor_ch_t)ch, value, data->timestamp);
+        }
+    }
+}
+
+int trend_get(sensor_ch_t ch, uint32_t horizon_s, trend_info_t *out)
+{
+    if (ch >= SENSOR_CH_COUNT || !out) {
+        return -EINVAL;
+    }
+
+    const trend_channel_t *c = &channels[ch];
+    double n, sx, sxx, sy, sxy, x_last;
+
+    k_mutex_lock(&trend_lock, K_FOREVER);
+    out->count = c->count;
+    n = c->count;
+    sx = (double)c->sx;
+    sxx = (double)c->sxx;
+    sy = (double)c->sy;
+    sxy = (double)c->sxy;
+    x_last = (double)rel_ms(c, c->t[(c->head + TREND_WINDOW - 1) % TREND_WINDOW]);
+    k_mutex_unlock(&trend_lock);
+
+    double den = n * sxx - sx * sx;
+
+    if (out->count < TREND_MIN_SAMPLES || den <= 0.0) {
+        return -ENODATA;
+    }
+
+    /* Least squares in milli-units per ms */
+    double slope = (n * sxy - sx * sy) / den;
+    double fit = sy / n + slope * (x_last - sx / n);
+
+    out->value = (float)(fit / 1000.0);
+    out->slope_per_min = (float)(slope * 60.0);
+    out->forecast = (float)((fit + slope * horizon_s * 1000.0) / 1000.0);
+
+    if (out->slope_per_min > steady_per_min[ch]) {
+        out->direction = 1;
+    } else if (out->slope_per_min < -steady_per_min[ch]) {
+        out->direction = -1;
+    } else {
+        out->direction = 0;
+    }
+    return 0;
+}
+
+char trend_arrow(sensor_ch_t ch)
+{
+    trend_info_t t;
+
+    if (trend_get(ch, 0, &t) != 0) {
+        return '?';
+    }
+    return (t.direction > 0) ? '^' : (t.direction < 0) ? 'v' : '-';
+}
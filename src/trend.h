@@ -0,0 +1,41 @@
+/**
+ * @file trend.h
+ * @brief Sliding-window linear regression per channel (slope, forecast)
+ *
+ * The last TREND_WINDOW samples of each channel are kept in a ring
+ * together with the running sums of t, t^2, y and t*y, so a sample
+ * costs O(1): its terms are added and those of the sample it replaces
+ * subtracted. Sums are exact integers (ms, milli-units); the time
+ * origin is moved forward now and then to keep them in range.
+ */
+
+#ifndef TREND_H
+#define TREND_H
+
+#include <stdint.h>
+#include "sensor_manager.h"
+
+#define TREND_WINDOW        120     /* Samples (2 min at 1 Hz) */
+#define TREND_MIN_SAMPLES   30      /* Fewer give no slope */
+
+typedef struct {
+    uint32_t count;             /* Samples in the window */
+    float value;                /* Fitted value at the latest sample */
+    float slope_per_min;        /* Units per minute */
+    float forecast;             /* Fitted value 'horizon' ahead */
+    int8_t direction;           /* -1 falling, 0 steady, +1 rising */
+} trend_info_t;
+
+void trend_init(void);
+
+/* Adds every valid channel of a sensor snapshot */
+void trend_add_data(const sensor_data_t *data);
+
+/* Fills out for a forecast 'horizon_s' ahead of the latest sample;
+ * returns 0, -EINVAL on bad args or -ENODATA with too few samples */
+int trend_get(sensor_ch_t ch, uint32_t horizon_s, trend_info_t *out);
+
+/* Arrow for the display: '^', 'v' or '-' ('?' without data) */
+char trend_arrow(sensor_ch_t ch);
+
+#endif /* TREND_H */
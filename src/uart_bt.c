@@ -1,58 +1,349 @@
 #include <zephyr/device.h>
 #include <zephyr/drivers/uart.h>
 #include <zephyr/kernel.h>
+#include <zephyr/logging/log.h>
+#include <zephyr/sys/ring_buffer.h>
 #include <string.h>
 #include <stdio.h>
+#include <math.h>
 
 #include "uart_bt.h"
 #include "env_controller.h"
 #include "command_parser.h"
 #include "adjust_manager.h"
 #include "mode_controller.h"
+#include "stats_rollup.h"
+#include "quantile_sketch.h"
+#include "sensor_manager.h"
+#include "app_channels.h"
+#include "loop_timing.h"
+#include "irrigation.h"
+#include "schedule.h"
+#include "rule_engine.h"
+#include "trend.h"
+#include "trace.h"
+
+LOG_MODULE_REGISTER(uart_bt, LOG_LEVEL_INF);
 
 /* UART node defined in the overlay */
 #define UART_BT_NODE DT_NODELABEL(uart3)
 static const struct device *const uart_bt = DEVICE_DT_GET(UART_BT_NODE);
 
-/* RX buffers */
-#define BT_RX_BUF_SIZE 64
-#define BT_MSGQ_SIZE   10
+/* RX: the ISR (or the DMA callback) only moves bytes into the ring;
+ * the thread frames lines in place. Sized for several command lines. */
+#define BT_RX_BUF_SIZE   64             /* Longest command line, NUL included */
+#define BT_RX_RING_SIZE  512
 
-K_MSGQ_DEFINE(bt_rx_msgq, BT_RX_BUF_SIZE, BT_MSGQ_SIZE, 4);
-static char rx_buffer[BT_RX_BUF_SIZE];
-static int rx_pos = 0;
+RING_BUF_DECLARE(bt_rx_ring, BT_RX_RING_SIZE);
+static struct k_spinlock rx_lock;       /* Producers: ISR and uart_bt_inject */
+static struct k_poll_signal bt_rx_signal = K_POLL_SIGNAL_INITIALIZER(bt_rx_signal);
 
-/* UART RX callback */
-static void uart_bt_callback(const struct device *dev, void *user_data)
+/* When the oldest unhandled wake-up was raised (under rx_lock) */
+static uint32_t rx_wake_cycles;
+static bool rx_wake_pending;
+
+/* Written by the ISR */
+static atomic_t rx_bytes;
+static atomic_t rx_dropped;             /* Ring full, byte discarded */
+static atomic_t rx_hw_overruns;         /* UART FIFO overrun flagged */
+
+/* Time spent in the UART callbacks, for the CPU load */
+static struct k_spinlock irq_stat_lock;
+static uint32_t irq_calls;
+static uint64_t irq_cycles;
+
+/* Thread side */
+static uint32_t rx_line_cycles;         /* Arrival of the lines being handled */
+static uint32_t rx_lines;
+static uint32_t rx_too_long;            /* Lines over BT_RX_BUF_SIZE, discarded */
+static bool rx_discarding;              /* Inside an overlong line */
+
+/* TX: senders queue into the ring and return, the TX-ready interrupt
+ * (or DMA transfers) drain it. Holds the longest reply (the banner)
+ * with room to spare. */
+#define BT_TX_RING_SIZE  1024
+#define BT_TX_WAIT_MS    2000           /* Longest a reply waits for room */
+
+RING_BUF_DECLARE(bt_tx_ring, BT_TX_RING_SIZE);
+static struct k_spinlock tx_lock;       /* Senders and the ISR */
+K_SEM_DEFINE(tx_space_sem, 0, 1);
+
+static atomic_t tx_bytes;               /* Handed to the FIFO by the ISR */
+static uint32_t tx_waits;               /* Sends that found the ring full */
+static uint32_t tx_dropped;             /* Bytes not sent: notification or timeout */
+static uint32_t tx_high_water;
+
+#ifdef CONFIG_GREENHOUSE_BT_ASYNC
+#define BT_UART_MODE        "async"
+
+/* Async RX: two DMA buffers chained on UART_RX_BUF_REQUEST, so the
+ * controller never waits for the CPU; RX_RDY comes when a buffer fills
+ * or the line goes idle */
+#define BT_RX_DMA_BUF_SIZE  64
+#define BT_RX_IDLE_US       2000        /* Two characters at 9600 baud */
+
+static uint8_t rx_dma_buf[2][BT_RX_DMA_BUF_SIZE];
+static uint8_t rx_dma_next;             /* Buffer for the next request */
+static bool tx_busy;                    /* A uart_tx of the ring is running */
+#else
+#define BT_UART_MODE        "irq"
+#endif
+
+/* Mode / actuator changes to notify, filled in by the zbus listener */
+#define BT_NOTIFY_MODE      BIT(0)
+#define BT_NOTIFY_ACTUATOR  BIT(1)
+
+static struct k_poll_signal bt_notify_signal = K_POLL_SIGNAL_INITIALIZER(bt_notify_signal);
+static struct k_spinlock notify_lock;
+static uint32_t notify_pending;
+static app_mode_msg_t notify_mode;
+static app_actuator_msg_t notify_actuator;
+
+/* Runs in the publisher's context: latch the message and wake the thread */
+static void bt_listener_cb(const struct zbus_channel *chan)
 {
-    uint8_t c;
+    k_spinlock_key_t key = k_spin_lock(&notify_lock);
 
-    if (!uart_irq_update(dev)) return;
-    if (!uart_irq_rx_ready(dev)) return;
+    if (chan == &mode_chan) {
+        notify_mode = *(const app_mode_msg_t *)zbus_chan_const_msg(chan);
+        notify_pending |= BT_NOTIFY_MODE;
+    } else if (chan == &actuator_chan) {
+        notify_actuator = *(const app_actuator_msg_t *)zbus_chan_const_msg(chan);
+        notify_pending |= BT_NOTIFY_ACTUATOR;
+    }
 
-    while (uart_fifo_read(dev, &c, 1) == 1) {
+    k_spin_unlock(&notify_lock, key);
+    k_poll_signal_raise(&bt_notify_signal, 0);
+}
 
-        /* Command finished on newline or carriage return */
-        if ((c == '\n' || c == '\r') && rx_pos > 0) {
-            rx_buffer[rx_pos] = '\0';
+ZBUS_LISTENER_DEFINE(bt_listener, bt_listener_cb);
 
-            /* Queue message regardless of mode.
-               adjust_manager decides what can be applied. */
-            k_msgq_put(&bt_rx_msgq, rx_buffer, K_NO_WAIT);
+/* Call with rx_lock held when the thread is about to be woken */
+static void rx_stamp_wake_locked(void)
+{
+    if (!rx_wake_pending) {
+        rx_wake_cycles = k_cycle_get_32();
+        rx_wake_pending = true;
+    }
+}
 
-            printk("[BT] Received: %s\n", rx_buffer);
-            rx_pos = 0;
+static void irq_account(uint32_t start)
+{
+    k_spinlock_key_t key = k_spin_lock(&irq_stat_lock);
+    irq_calls++;
+    irq_cycles += k_cycle_get_32() - start;
+    k_spin_unlock(&irq_stat_lock, key);
+}
+
+#ifndef CONFIG_GREENHOUSE_BT_ASYNC
+/* RX interrupt: no copies beyond the FIFO read, no logging */
+static void uart_bt_rx_isr(const struct device *dev)
+{
+    bool wake = false;
+    uint8_t *dst;
+    uint32_t space;
+    int n, err;
+
+    err = uart_err_check(dev);
+    if (err > 0 && (err & UART_ERROR_OVERRUN)) {
+        atomic_inc(&rx_hw_overruns);
+    }
+
+    k_spinlock_key_t key = k_spin_lock(&rx_lock);
+
+    do {
+        space = ring_buf_put_claim(&bt_rx_ring, &dst, BT_RX_RING_SIZE);
+        if (space == 0) {
+            /* Drain the FIFO anyway so the interrupt clears */
+            uint8_t discard;
+
+            n = uart_fifo_read(dev, &discard, 1);
+            if (n > 0) {
+                atomic_inc(&rx_dropped);
+                wake = true;
+            }
+            continue;
         }
-        else if (rx_pos < BT_RX_BUF_SIZE - 1) {
-            rx_buffer[rx_pos++] = c;
+
+        /* The FIFO is read straight into the ring */
+        n = uart_fifo_read(dev, dst, space);
+        if (n <= 0) {
+            ring_buf_put_finish(&bt_rx_ring, 0);
+            break;
         }
-        else {
-            printk("[BT] Buffer overflow\n");
-            rx_pos = 0;
+        for (int i = 0; i < n && !wake; i++) {
+            wake = (dst[i] == '\n' || dst[i] == '\r');
         }
+        ring_buf_put_finish(&bt_rx_ring, n);
+        atomic_add(&rx_bytes, n);
+    } while (n > 0);
+
+    /* The thread only wakes for a complete line, or a full ring */
+    wake = wake || ring_buf_space_get(&bt_rx_ring) == 0;
+    if (wake) {
+        rx_stamp_wake_locked();
+    }
+
+    k_spin_unlock(&rx_lock, key);
+
+    if (wake) {
+        k_poll_signal_raise(&bt_rx_signal, 0);
     }
 }
 
+/* TX interrupt: refills the FIFO from the ring, off when it runs dry */
+static void uart_bt_tx_isr(const struct device *dev)
+{
+    uint8_t *src;
+    uint32_t len;
+    int n = 0;
+
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+
+    len = ring_buf_get_claim(&bt_tx_ring, &src, BT_TX_RING_SIZE);
+    if (len == 0) {
+        uart_irq_tx_disable(dev);
+    } else {
+        n = uart_fifo_fill(dev, src, (int)len);
+    }
+    ring_buf_get_finish(&bt_tx_ring, (n > 0) ? n : 0);
+
+    k_spin_unlock(&tx_lock, key);
+
+    if (n > 0) {
+        atomic_add(&tx_bytes, n);
+        k_sem_give(&tx_space_sem);
+    }
+}
+
+static void uart_bt_callback(const struct device *dev, void *user_data)
+{
+    uint32_t start = k_cycle_get_32();
+
+    if (!uart_irq_update(dev)) return;
+
+    if (uart_irq_rx_ready(dev)) {
+        uart_bt_rx_isr(dev);
+    }
+    if (uart_irq_tx_ready(dev)) {
+        uart_bt_tx_isr(dev);
+    }
+    irq_account(start);
+}
+
+/* Starts draining the TX ring */
+static void uart_bt_tx_kick(void)
+{
+    /* The ISR turns it off again once the ring is empty */
+    uart_irq_tx_enable(uart_bt);
+}
+
+#else
+/* Copies a received DMA stretch into the ring */
+static void uart_bt_rx_push(const uint8_t *data, uint32_t len)
+{
+    bool wake = false;
+    uint32_t n;
+
+    k_spinlock_key_t key = k_spin_lock(&rx_lock);
+    n = ring_buf_put(&bt_rx_ring, data, len);
+    k_spin_unlock(&rx_lock, key);
+
+    atomic_add(&rx_bytes, n);
+    if (n < len) {
+        atomic_add(&rx_dropped, len - n);
+        wake = true;
+    }
+    for (uint32_t i = 0; i < n && !wake; i++) {
+        wake = (data[i] == '\n' || data[i] == '\r');
+    }
+    if (wake) {
+        key = k_spin_lock(&rx_lock);
+        rx_stamp_wake_locked();
+        k_spin_unlock(&rx_lock, key);
+        k_poll_signal_raise(&bt_rx_signal, 0);
+    }
+}
+
+/* Call with tx_lock held: sends the next stretch of the ring */
+static void uart_bt_tx_start(void)
+{
+    uint8_t *src;
+    uint32_t len;
+
+    if (tx_busy) {
+        return;
+    }
+    len = ring_buf_get_claim(&bt_tx_ring, &src, BT_TX_RING_SIZE);
+    if (len == 0) {
+        return;
+    }
+    if (uart_tx(uart_bt, src, len, SYS_FOREVER_US) == 0) {
+        tx_busy = true;
+    } else {
+        ring_buf_get_finish(&bt_tx_ring, 0);
+    }
+}
+
+static void uart_bt_tx_done(uint32_t len)
+{
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+    ring_buf_get_finish(&bt_tx_ring, len);
+    tx_busy = false;
+    uart_bt_tx_start();
+    k_spin_unlock(&tx_lock, key);
+
+    atomic_add(&tx_bytes, len);
+    k_sem_give(&tx_space_sem);
+}
+
+static void uart_bt_async_callback(const struct device *dev, struct uart_event *evt,
+                                   void *user_data)
+{
+    uint32_t start = k_cycle_get_32();
+
+    switch (evt->type) {
+    case UART_RX_RDY:
+        uart_bt_rx_push(&evt->data.rx.buf[evt->data.rx.offset], evt->data.rx.len);
+        break;
+
+    case UART_RX_BUF_REQUEST:
+        /* Chain the other buffer before this one is full */
+        uart_rx_buf_rsp(dev, rx_dma_buf[rx_dma_next], sizeof(rx_dma_buf[0]));
+        rx_dma_next ^= 1;
+        break;
+
+    case UART_RX_STOPPED:
+        if (evt->data.rx_stop.reason & UART_ERROR_OVERRUN) {
+            atomic_inc(&rx_hw_overruns);
+        }
+        break;
+
+    case UART_RX_DISABLED:
+        /* Stopped by an error: start over */
+        rx_dma_next = 1;
+        uart_rx_enable(dev, rx_dma_buf[0], sizeof(rx_dma_buf[0]), BT_RX_IDLE_US);
+        break;
+
+    case UART_TX_DONE:
+    case UART_TX_ABORTED:
+        uart_bt_tx_done(evt->data.tx.len);
+        break;
+
+    default:
+        break;
+    }
+    irq_account(start);
+}
+
+static void uart_bt_tx_kick(void)
+{
+    k_spinlock_key_t key = k_spin_lock(&tx_lock);
+    uart_bt_tx_start();
+    k_spin_unlock(&tx_lock, key);
+}
+#endif /* CONFIG_GREENHOUSE_BT_ASYNC */
+
 /* UART initialization */
 int uart_bt_init(void)
 {
@@ -61,100 +352,919 @@ int uart_bt_init(void)
         return -ENODEV;
     }
 
+#ifdef CONFIG_GREENHOUSE_BT_ASYNC
+    int ret = uart_callback_set(uart_bt, uart_bt_async_callback, NULL);
+
+    if (ret == 0) {
+        rx_dma_next = 1;
+        ret = uart_rx_enable(uart_bt, rx_dma_buf[0], sizeof(rx_dma_buf[0]), BT_RX_IDLE_US);
+    }
+    if (ret != 0) {
+        printk("ERROR: Bluetooth UART async API unavailable (%d)\n", ret);
+        return ret;
+    }
+
+    printk("Bluetooth UART initialized (9600 baud, " BT_UART_MODE ")\n");
+#else
     uart_irq_callback_user_data_set(uart_bt, uart_bt_callback, NULL);
     uart_irq_rx_enable(uart_bt);
 
     printk("Bluetooth UART initialized (9600 baud)\n");
+#endif
+    return 0;
+}
+
+/* Queues a string for the HC-05. With K_NO_WAIT it is queued whole or
+ * not at all; otherwise it waits up to 'timeout' each time the ring is
+ * full. Returns 0, or -EAGAIN when (the rest of) it was dropped. */
+static int uart_bt_write(const char *str, k_timeout_t timeout)
+{
+    const uint8_t *p = (const uint8_t *)str;
+    uint32_t len = strlen(str);
+    bool no_wait = K_TIMEOUT_EQ(timeout, K_NO_WAIT);
+
+    if (!device_is_ready(uart_bt)) return -ENODEV;
+
+    while (len > 0) {
+        uint32_t n = 0;
+
+        k_spinlock_key_t key = k_spin_lock(&tx_lock);
+        if (!no_wait || ring_buf_space_get(&bt_tx_ring) >= len) {
+            n = ring_buf_put(&bt_tx_ring, p, len);
+        }
+        tx_high_water = MAX(tx_high_water, ring_buf_size_get(&bt_tx_ring));
+        k_spin_unlock(&tx_lock, key);
+
+        if (n > 0) {
+            uart_bt_tx_kick();
+            p += n;
+            len -= n;
+            continue;
+        }
+
+        tx_waits++;
+        if (no_wait || k_sem_take(&tx_space_sem, timeout) != 0) {
+            tx_dropped += len;
+            return -EAGAIN;
+        }
+    }
     return 0;
 }
 
-/* Helper to send a string to HC-05 */
+/* Replies: only ever wait when a long reply fills the ring */
 static void uart_bt_send(const char *str)
 {
-    if (!device_is_ready(uart_bt)) return;
+    uart_bt_write(str, K_MSEC(BT_TX_WAIT_MS));
+}
+
+/* Replies to a STATS query with the requested aggregate */
+static void uart_bt_send_stats(sensor_ch_t ch, stats_window_t win)
+{
+    stats_summary_t sum;
+    char response[96];
 
-    for (size_t i = 0; str[i] != '\0'; i++)
-        uart_poll_out(uart_bt, str[i]);
+    if (stats_rollup_get(ch, win, &sum) != 0) {
+        snprintf(response, sizeof(response), "%s %s: no data\r\n",
+                 sensor_channel_name(ch), stats_window_name(win));
+    } else {
+        snprintf(response, sizeof(response),
+                 "%s %s: n=%u min=%.1f max=%.1f avg=%.1f sd=%.2f\r\n",
+                 sensor_channel_name(ch), stats_window_name(win),
+                 (unsigned int)sum.count,
+                 (double)sum.min, (double)sum.max, (double)sum.mean,
+                 (double)sqrtf(sum.variance));
+    }
+    uart_bt_send(response);
 }
 
-/* Main Bluetooth thread */
-void uart_bt_thread(void *p1, void *p2, void *p3)
+/* Replies to PCT / BELOW queries from the daily quantile sketch */
+static void uart_bt_send_quantile(const parser_result_t *q)
 {
-    uart_bt_init();
+    const char *day = (q->day == QUANTILE_DAY_TODAY) ? "today" : "yday";
+    char response[64];
+    float result;
+    int ret;
+
+    if (q->action == PARSER_ACTION_QUERY_PERCENTILE) {
+        ret = quantile_sketch_percentile(q->channel, q->day, q->query_value, &result);
+        if (ret == 0) {
+            snprintf(response, sizeof(response), "%s P%.0f %s: %.1f\r\n",
+                     sensor_channel_name(q->channel), (double)q->query_value,
+                     day, (double)result);
+        }
+    } else {
+        ret = quantile_sketch_fraction_below(q->channel, q->day, q->query_value, &result);
+        if (ret == 0) {
+            snprintf(response, sizeof(response), "%s <%.1f %s: %.1f%%\r\n",
+                     sensor_channel_name(q->channel), (double)q->query_value,
+                     day, (double)(result * 100.0f));
+        }
+    }
+
+    if (ret != 0) {
+        snprintf(response, sizeof(response), "%s %s: no data\r\n",
+                 sensor_channel_name(q->channel), day);
+    }
+    uart_bt_send(response);
+}
+
+/* Replies to HEALTH with sensor breaker states, channel ages and state counters */
+static void uart_bt_send_health(void)
+{
+    char response[96];
+    sensor_health_t h;
+
+    for (int i = 0; i < sensor_manager_device_count(); i++) {
+        sensor_manager_get_health((sensor_dev_t)i, &h);
+        snprintf(response, sizeof(response),
+                 "%s: %s fails=%u/%u skipped=%u err=%d\r\n",
+                 sensor_device_name((sensor_dev_t)i),
+                 sensor_health_state_name(h.state),
+                 (unsigned int)h.consecutive_failures,
+                 (unsigned int)h.total_failures,
+                 (unsigned int)h.total_skipped, h.last_error);
+        uart_bt_send(response);
+    }
+
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        uint32_t age = sensor_manager_channel_age_ms((sensor_ch_t)ch);
+
+        if (age == UINT32_MAX) {
+            snprintf(response, sizeof(response), "%s age: never\r\n",
+                     sensor_channel_name((sensor_ch_t)ch));
+        } else {
+            snprintf(response, sizeof(response), "%s age: %u ms%s\r\n",
+                     sensor_channel_name((sensor_ch_t)ch), (unsigned int)age,
+                     (age > SENSOR_STALE_MS) ? " STALE" : "");
+        }
+        uart_bt_send(response);
+    }
+
+    env_controller_stats_t es;
+    env_controller_get_stats(&es);
+    snprintf(response, sizeof(response), "ENV: gen=%u writes=%u retries=%u\r\n",
+             (unsigned int)env_controller_generation(), (unsigned int)es.writes,
+             (unsigned int)es.read_retries);
+    uart_bt_send(response);
+
+    app_latency_t lat;
+    app_channels_get_latency(&lat);
+    snprintf(response, sizeof(response), "BUS: n=%u avg=%u us max=%u us\r\n",
+             (unsigned int)lat.count, (unsigned int)lat.avg_us, (unsigned int)lat.max_us);
+    uart_bt_send(response);
+
+    app_channels_get_event_latency(&lat);
+    snprintf(response, sizeof(response), "EVT: n=%u avg=%u us max=%u us\r\n",
+             (unsigned int)lat.count, (unsigned int)lat.avg_us, (unsigned int)lat.max_us);
+    uart_bt_send(response);
+
+    snprintf(response, sizeof(response),
+             "BT RX: bytes=%u lines=%u dropped=%u long=%u overruns=%u\r\n",
+             (unsigned int)atomic_get(&rx_bytes), (unsigned int)rx_lines,
+             (unsigned int)atomic_get(&rx_dropped), (unsigned int)rx_too_long,
+             (unsigned int)atomic_get(&rx_hw_overruns));
+    uart_bt_send(response);
+
+    snprintf(response, sizeof(response),
+             "BT TX: bytes=%u max=%u/%u waits=%u dropped=%u\r\n",
+             (unsigned int)atomic_get(&tx_bytes), (unsigned int)tx_high_water,
+             (unsigned int)BT_TX_RING_SIZE, (unsigned int)tx_waits,
+             (unsigned int)tx_dropped);
+    uart_bt_send(response);
+
+    /* CPU share of the UART callbacks, in hundredths of a percent */
+    k_spinlock_key_t key = k_spin_lock(&irq_stat_lock);
+    uint32_t calls = irq_calls;
+    uint64_t busy_us = k_cyc_to_us_floor64(irq_cycles);
+    k_spin_unlock(&irq_stat_lock, key);
 
+    uint64_t up_us = (uint64_t)k_uptime_get() * 1000U;
+    uint32_t load = (up_us > 0) ? (uint32_t)(busy_us * 10000U / up_us) : 0;
+
+    snprintf(response, sizeof(response),
+             "BT IRQ: calls=%u busy=%u us load=%u.%02u%% (%s)\r\n",
+             (unsigned int)calls, (unsigned int)busy_us,
+             (unsigned int)(load / 100), (unsigned int)(load % 100), BT_UART_MODE);
+    uart_bt_send(response);
+
+    adjust_latency_t act;
+    adjust_manager_get_latency(&act);
+    snprintf(response, sizeof(response),
+             "ACTUATE: n=%u avg=%u us max=%u us slow=%u writes=%u\r\n",
+             (unsigned int)act.transitions, (unsigned int)act.avg_us,
+             (unsigned int)act.max_us, (unsigned int)act.over_budget,
+             (unsigned int)actuator_output_port_writes());
+    uart_bt_send(response);
+
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        adjust_counters_t c;
+        actuator_usage_t u;
+
+        adjust_manager_get_counters((actuator_id_t)i, &c);
+        actuator_output_get_usage((actuator_id_t)i, &u);
+        snprintf(response, sizeof(response),
+                 "%s: switches=%u held=%u stale=%u duty24h=%u.%u%%\r\n",
+                 actuator_name((actuator_id_t)i), (unsigned int)u.switches,
+                 (unsigned int)c.held, (unsigned int)c.stale_off,
+                 (unsigned int)(u.duty_24h_permille / 10),
+                 (unsigned int)(u.duty_24h_permille % 10));
+        uart_bt_send(response);
+    }
+}
+
+/* Replies to USAGE with on-time, switches, rolling duty and energy */
+static void uart_bt_send_usage(void)
+{
+    char response[96];
+    float total_wh = 0.0f;
+
+    for (int i = 0; i < ACTUATOR_COUNT; i++) {
+        actuator_usage_t u;
+
+        actuator_output_get_usage((actuator_id_t)i, &u);
+        snprintf(response, sizeof(response),
+                 "%s: on=%us sw=%u 1h=%u.%u%% 24h=%u.%u%% %.1fWh@%uW\r\n",
+                 actuator_name((actuator_id_t)i), (unsigned int)(u.on_ms / 1000U),
+                 (unsigned int)u.switches,
+                 (unsigned int)(u.duty_1h_permille / 10), (unsigned int)(u.duty_1h_permille % 10),
+                 (unsigned int)(u.duty_24h_permille / 10), (unsigned int)(u.duty_24h_permille % 10),
+                 (double)u.energy_wh, (unsigned int)u.rated_w);
+        uart_bt_send(response);
+        total_wh += u.energy_wh;
+    }
+
+    snprintf(response, sizeof(response), "ENERGY: %.1fWh\r\n", (double)total_wh);
+    uart_bt_send(response);
+}
+
+/* Replies to TREND with slope and forecast per channel, and the
+ * excursions above the temperature target with and without
+ * feed-forward */
+static void uart_bt_send_trend(void)
+{
+    adjust_ff_info_t ff;
+    char response[96];
+
+    adjust_manager_get_feed_forward(&ff);
+
+    for (int ch = 0; ch < SENSOR_CH_COUNT; ch++) {
+        trend_info_t t;
+
+        if (trend_get((sensor_ch_t)ch, ff.horizon_s, &t) != 0) {
+            snprintf(response, sizeof(response), "%s: no trend (n=%u)\r\n",
+                     sensor_channel_name((sensor_ch_t)ch), (unsigned int)t.count);
+        } else {
+            snprintf(response, sizeof(response), "%s: %c %.2f/min now=%.2f in %us=%.2f\r\n",
+                     sensor_channel_name((sensor_ch_t)ch), trend_arrow((sensor_ch_t)ch),
+                     (double)t.slope_per_min, (double)t.value,
+                     (unsigned int)ff.horizon_s, (double)t.forecast);
+        }
+        uart_bt_send(response);
+    }
+
+    snprintf(response, sizeof(response), "FF: %s\r\n", ff.enabled ? "on" : "off");
+    uart_bt_send(response);
+    for (int m = 0; m < 2; m++) {
+        snprintf(response, sizeof(response), "OVER %s: max=%.2fC above=%us of %us\r\n",
+                 m ? "ff" : "no-ff", (double)ff.over_max[m],
+                 (unsigned int)ff.over_s[m], (unsigned int)ff.run_s[m]);
+        uart_bt_send(response);
+    }
+}
+
+/* Replies to TIMING with the control cycle jitter/overrun histogram */
+static void uart_bt_send_timing(void)
+{
+    loop_timing_stats_t st;
+    char response[128];
+    int len = 0;
+
+    loop_timing_get(&st);
+
+    snprintf(response, sizeof(response),
+             "CYCLE: n=%u missed=%u overrun=%u jmax=%u us busy=%u/%u us\r\n",
+             (unsigned int)st.cycles, (unsigned int)st.missed,
+             (unsigned int)st.overruns, (unsigned int)st.jitter_max_us,
+             (unsigned int)st.busy_avg_us, (unsigned int)st.busy_max_us);
+    uart_bt_send(response);
+
+    len = snprintf(response, sizeof(response), "JITTER:");
+    for (int i = 0; i < LOOP_TIMING_BINS && len < (int)sizeof(response); i++) {
+        if (i < LOOP_TIMING_BINS - 1) {
+            len += snprintf(response + len, sizeof(response) - len, " <%u:%u",
+                            (unsigned int)loop_timing_bin_us[i], (unsigned int)st.hist[i]);
+        } else {
+            len += snprintf(response + len, sizeof(response) - len, " more:%u\r\n",
+                            (unsigned int)st.hist[i]);
+        }
+    }
+    uart_bt_send(response);
+}
+
+/* Replies to PID with the fan controller state and the last step response */
+static void uart_bt_send_pid(void)
+{
+    adjust_pid_info_t pid;
+    adjust_step_response_t step;
+    char response[96];
+    int ret;
+
+    adjust_manager_get_pid(&pid);
+    snprintf(response, sizeof(response), "PID: %s kp=%.2f ki=%.3f kd=%.2f duty=%u.%u%%\r\n",
+             !pid.available ? "n/a" : (pid.enabled ? "on" : "off"),
+             (double)pid.kp, (double)pid.ki, (double)pid.kd,
+             (unsigned int)(pid.duty_permille / 10), (unsigned int)(pid.duty_permille % 10));
+    uart_bt_send(response);
+
+    ret = adjust_manager_get_step_response(&step);
+    if (ret == -ENODATA) {
+        uart_bt_send("STEP: none\r\n");
+        return;
+    }
+    snprintf(response, sizeof(response), "STEP: %s%s %s settle=%us overshoot=%.2fC\r\n",
+             step.pid ? "pid" : "on/off", step.ff ? "+ff" : "",
+             (ret == -EINPROGRESS) ? "settling" : "done",
+             (unsigned int)(step.settle_ms / 1000), (double)step.overshoot_mc / 1000.0);
+    uart_bt_send(response);
+}
+
+/* Replies to TUNE with the auto-tune run and the gains in use */
+static void uart_bt_send_tune(void)
+{
+    adjust_autotune_info_t at;
+    char response[96];
+
+    adjust_manager_get_autotune(&at);
+    if (at.state == AUTOTUNE_IDLE) {
+        uart_bt_send("TUNE: idle\r\n");
+    } else {
+        snprintf(response, sizeof(response), "TUNE: %s %s cycles=%d/%d Ku=%.2f Pu=%.0fs\r\n",
+                 actuator_name(at.target), autotune_state_name(at.state),
+                 MIN(at.cycles, AUTOTUNE_CYCLES + 1), AUTOTUNE_CYCLES + 1,
+                 (double)at.ku, (double)at.pu_s);
+        uart_bt_send(response);
+    }
+
+    for (int i = ACTUATOR_FAN; i <= ACTUATOR_IRRIGATION; i++) {
+        float g[3];
+        bool stored = adjust_manager_get_gains((actuator_id_t)i, g);
+
+        snprintf(response, sizeof(response), "%s gains: %.2f %.3f %.2f (%s)\r\n",
+                 actuator_name((actuator_id_t)i), (double)g[0], (double)g[1],
+                 (double)g[2], stored ? "stored" : "default");
+        uart_bt_send(response);
+    }
+}
+
+/* Replies to IRR with the pump mode, pulse counts and water use */
+static void uart_bt_send_irrigation(void)
+{
+    irrigation_stats_t irr;
+    char response[96];
+
+    irrigation_get_stats(&irr);
+    snprintf(response, sizeof(response), "IRR: %s fraction=%u.%u%% windows=%u pulses=%u\r\n",
+             adjust_manager_get_irrigation_tp() ? "tp" : "on/off",
+             (unsigned int)(irr.fraction_permille / 10),
+             (unsigned int)(irr.fraction_permille % 10),
+             (unsigned int)irr.windows, (unsigned int)irr.pulses);
+    uart_bt_send(response);
+
+    snprintf(response, sizeof(response), "WATER: %.1fL on=%us over=%.1f%% (%us >%.0f%%)\r\n",
+             (double)irr.water_ml / 1000.0, (unsigned int)(irr.on_ms / 1000U),
+             (double)irr.overshoot_max, (unsigned int)irr.overshoot_s,
+             (double)IRRIGATION_OVERSHOOT_BAND);
+    uart_bt_send(response);
+}
+
+/* Replies to COORD with the arbitration counters and the fan + pump
+ * on-time per hour in each mode */
+static void uart_bt_send_coord(void)
+{
+    adjust_coord_info_t co;
+    char response[96];
+
+    adjust_manager_get_coordination(&co);
+    snprintf(response, sizeof(response), "COORD: %s yield=%us defer=%us\r\n",
+             co.enabled ? "on" : "off", (unsigned int)co.yield_s, (unsigned int)co.defer_s);
+    uart_bt_send(response);
+
+    snprintf(response, sizeof(response), "ONTIME: indep=%us/h (%us) coord=%us/h (%us)\r\n",
+             (unsigned int)co.on_s_per_h[0], (unsigned int)co.run_s[0],
+             (unsigned int)co.on_s_per_h[1], (unsigned int)co.run_s[1]);
+    uart_bt_send(response);
+}
+
+/* Replies to SCHED with the clock, the active entry and the table */
+static void uart_bt_send_schedule(void)
+{
+    schedule_info_t info;
+    schedule_entry_t e;
+    char response[80];
+
+    schedule_get_info(&info);
+    snprintf(response, sizeof(response),
+             "SCHED: %s clock=%02u:%02u%s entries=%d active=%d next=%02u:%02u\r\n",
+             info.enabled ? "on" : "off", info.now_min / 60, info.now_min % 60,
+             info.clock_set ? "" : "(unset)", info.count, info.active,
+             info.next_min / 60, info.next_min % 60);
+    uart_bt_send(response);
+
+    for (int i = 0; schedule_get_entry(i, &e) == 0; i++) {
+        snprintf(response, sizeof(response), "  %d %02u:%02u T=%.1f H=%.1f L=%.0f\r\n",
+                 i, e.start_min / 60, e.start_min % 60,
+                 (double)e.setpoints.target_temperature,
+                 (double)e.setpoints.target_humidity,
+                 (double)e.setpoints.target_light);
+        uart_bt_send(response);
+    }
+}
+
+/* Replies to RULES with each rule, its state and evaluation time */
+static void uart_bt_send_rules(void)
+{
+    rule_info_t r;
+    char response[96];
+
+    snprintf(response, sizeof(response), "RULES: %d/%d\r\n", rule_engine_count(), RULE_MAX);
+    uart_bt_send(response);
+
+    for (int i = 0; rule_engine_get(i, &r) == 0; i++) {
+        snprintf(response, sizeof(response), "  %d %s\r\n", i, r.text);
+        uart_bt_send(response);
+        snprintf(response, sizeof(response),
+                 "    %s %s hold=%us %s fired=%u code=%uB eval=%u/%uns\r\n",
+                 actuator_name((actuator_id_t)r.actuator), r.on ? "on" : "off",
+                 (unsigned int)r.hold_s, r.active ? "ACTIVE" : "idle",
+                 (unsigned int)r.fired, (unsigned int)r.code_len,
+                 (unsigned int)r.eval_avg_ns, (unsigned int)r.eval_max_ns);
+        uart_bt_send(response);
+    }
+}
+
+/* Replies to TRACE with the recorder state */
+static void uart_bt_send_trace(void)
+{
+    trace_info_t t;
+    char response[96];
+
+    trace_get_info(&t);
+    snprintf(response, sizeof(response),
+             "TRACE: %s %u/%uB records=%u dropped=%u span=%us\r\n",
+             t.enabled ? "on" : "off", (unsigned int)t.bytes, (unsigned int)t.capacity,
+             (unsigned int)t.records, (unsigned int)t.dropped,
+             (unsigned int)(t.span_ms / 1000));
+    uart_bt_send(response);
+}
+
+/* Sends the latched mode / actuator notifications. Telemetry never
+ * waits for the UART: with the ring full it is dropped (and counted). */
+static void uart_bt_send_notifications(void)
+{
+    app_mode_msg_t mode;
+    app_actuator_msg_t act;
+    uint32_t pending;
+    char response[48];
+
+    k_spinlock_key_t key = k_spin_lock(&notify_lock);
+    pending = notify_pending;
+    notify_pending = 0;
+    mode = notify_mode;
+    act = notify_actuator;
+    k_spin_unlock(&notify_lock, key);
+
+    if (pending & BT_NOTIFY_MODE) {
+        app_channels_note_latency(mode.cycles);
+        uart_bt_write(mode.mode == ENV_MODE_ADJUSTING ? "MODE: ADJUST\r\n"
+                                                      : "MODE: READ\r\n",
+                      K_NO_WAIT);
+    }
+
+    if (pending & BT_NOTIFY_ACTUATOR) {
+        app_channels_note_latency(act.cycles);
+        snprintf(response, sizeof(response), "ACT: fan=%d pump=%d light=%d\r\n",
+                 (act.active & APP_ACTUATOR_FAN) ? 1 : 0,
+                 (act.active & APP_ACTUATOR_IRRIGATION) ? 1 : 0,
+                 (act.active & APP_ACTUATOR_LIGHT) ? 1 : 0);
+        uart_bt_write(response, K_NO_WAIT);
+    }
+}
+
+/* Parses and executes one received command line */
+static void uart_bt_handle_command(const char *cmd_buffer)
+{
+    /* Every line goes into the trace, valid or not */
+    trace_record_command(cmd_buffer);
+
+    /* Read the current setpoints */
+    env_setpoints_t current_sp;
+    env_controller_get_setpoints(&current_sp);
+
+    /* Parse command using the NEW parser */
+    parser_result_t parsed =
+        command_parser_parse(cmd_buffer, &current_sp);
+
+    bool apply_setpoints = false;
+    bool change_mode = false;
+    env_mode_t new_mode = env_controller_get_mode();
+
+    /* Interpret parser output */
+    switch (parsed.action) {
+
+    case PARSER_ACTION_SET_SETPOINTS:
+        apply_setpoints = true;
+        break;
+
+    case PARSER_ACTION_MODE_READ:
+        new_mode = ENV_MODE_READ_ONLY;
+        change_mode = true;
+        break;
+
+    case PARSER_ACTION_MODE_ADJUST:
+        new_mode = ENV_MODE_ADJUSTING;
+        change_mode = true;
+        break;
+
+    case PARSER_ACTION_QUERY_STATS:
+        /* Read-only query, allowed in any mode */
+        uart_bt_send_stats(parsed.channel, parsed.window);
+        return;
+
+    case PARSER_ACTION_QUERY_HEALTH:
+        uart_bt_send_health();
+        return;
+
+    case PARSER_ACTION_QUERY_USAGE:
+        uart_bt_send_usage();
+        return;
+
+    case PARSER_ACTION_QUERY_TREND:
+        uart_bt_send_trend();
+        return;
+
+    case PARSER_ACTION_SET_FEED_FORWARD:
+        if (env_controller_get_mode() != ENV_MODE_ADJUSTING) {
+            uart_bt_send("ERROR: Mode is READ\r\n");
+        } else {
+            adjust_manager_set_feed_forward(parsed.enable);
+            uart_bt_send("OK: Feed-forward updated\r\n");
+        }
+        return;
+
+    case PARSER_ACTION_QUERY_TIMING:
+        uart_bt_send_timing();
+        return;
+
+    case PARSER_ACTION_QUERY_PID:
+        uart_bt_send_pid();
+        return;
+
+    case PARSER_ACTION_QUERY_TUNE:
+        uart_bt_send_tune();
+        return;
+
+    case PARSER_ACTION_START_TUNE:
+    case PARSER_ACTION_STOP_TUNE:
+        if (env_controller_get_mode() != ENV_MODE_ADJUSTING) {
+            uart_bt_send("ERROR: Mode is READ\r\n");
+        } else if (parsed.action == PARSER_ACTION_STOP_TUNE) {
+            adjust_manager_autotune_stop();
+            uart_bt_send("OK: Tuning stopped\r\n");
+        } else if (adjust_manager_autotune_start(parsed.actuator) != 0) {
+            uart_bt_send("ERROR: Tuning already running\r\n");
+        } else {
+            uart_bt_send("OK: Tuning started\r\n");
+        }
+        return;
+
+    case PARSER_ACTION_SET_PID_ENABLE:
+    case PARSER_ACTION_SET_PID_GAINS:
+        /* Tuning changes the control loop: same rule as setpoints */
+        if (env_controller_get_mode() != ENV_MODE_ADJUSTING) {
+            uart_bt_send("ERROR: Mode is READ\r\n");
+        } else if (parsed.action == PARSER_ACTION_SET_PID_GAINS) {
+            adjust_manager_set_pid_gains(parsed.gains[0], parsed.gains[1], parsed.gains[2]);
+            uart_bt_send("OK: Gains set\r\n");
+        } else if (adjust_manager_set_pid_enabled(parsed.enable) != 0) {
+            uart_bt_send("ERROR: No PWM fan\r\n");
+        } else {
+            uart_bt_send("OK: PID updated\r\n");
+        }
+        return;
+
+    case PARSER_ACTION_QUERY_IRRIGATION:
+        uart_bt_send_irrigation();
+        return;
+
+    case PARSER_ACTION_SET_IRRIGATION_MODE:
+        if (env_controller_get_mode() != ENV_MODE_ADJUSTING) {
+            uart_bt_send("ERROR: Mode is READ\r\n");
+        } else {
+            adjust_manager_set_irrigation_tp(parsed.enable);
+            uart_bt_send("OK: Irrigation mode set\r\n");
+        }
+        return;
+
+    case PARSER_ACTION_QUERY_COORD:
+        uart_bt_send_coord();
+        return;
+
+    case PARSER_ACTION_SET_COORD:
+        if (env_controller_get_mode() != ENV_MODE_ADJUSTING) {
+            uart_bt_send("ERROR: Mode is READ\r\n");
+        } else {
+            adjust_manager_set_coordinated(parsed.enable);
+            uart_bt_send("OK: Coordination updated\r\n");
+        }
+        return;
+
+    case PARSER_ACTION_QUERY_SCHEDULE:
+        uart_bt_send_schedule();
+        return;
+
+    case PARSER_ACTION_SCHEDULE_ADD:
+    case PARSER_ACTION_SCHEDULE_CLEAR:
+    case PARSER_ACTION_SCHEDULE_ENABLE:
+    case PARSER_ACTION_SET_CLOCK:
+        /* The schedule writes setpoints: same rule as setting them */
+        if (env_controller_get_mode() != ENV_MODE_ADJUSTING) {
+            uart_bt_send("ERROR: Mode is READ\r\n");
+        } else if (parsed.action == PARSER_ACTION_SCHEDULE_ADD) {
+            schedule_entry_t entry = {
+                .start_min = parsed.minute,
+                .setpoints = parsed.new_setpoints,
+            };
+            int rc = schedule_add(&entry);
+
+            uart_bt_send(rc == 0 ? "OK: Entry added\r\n" :
+                         rc == -ENOSPC ? "ERROR: Schedule full\r\n"
+                                       : "ERROR: Out of range\r\n");
+        } else if (parsed.action == PARSER_ACTION_SCHEDULE_CLEAR) {
+            schedule_clear();
+            uart_bt_send("OK: Schedule cleared\r\n");
+        } else if (parsed.action == PARSER_ACTION_SCHEDULE_ENABLE) {
+            schedule_enable(parsed.enable);
+            uart_bt_send("OK: Schedule updated\r\n");
+        } else {
+            schedule_set_clock(parsed.minute);
+            uart_bt_send("OK: Clock set\r\n");
+        }
+        return;
+
+    case PARSER_ACTION_QUERY_RULES:
+        uart_bt_send_rules();
+        return;
+
+    case PARSER_ACTION_RULE_ADD:
+    case PARSER_ACTION_RULE_REMOVE:
+    case PARSER_ACTION_RULE_CLEAR:
+        /* Rules drive the actuators: same rule as setpoints */
+        if (env_controller_get_mode() != ENV_MODE_ADJUSTING) {
+            uart_bt_send("ERROR: Mode is READ\r\n");
+        } else if (parsed.action == PARSER_ACTION_RULE_ADD) {
+            const char *err;
+            char response[80];
+            int rc = rule_engine_add(parsed.text, &err);
+
+            if (rc >= 0) {
+                snprintf(response, sizeof(response), "OK: Rule %d added\r\n", rc);
+            } else {
+                snprintf(response, sizeof(response), "ERROR: %s\r\n", err);
+            }
+            uart_bt_send(response);
+        } else if (parsed.action == PARSER_ACTION_RULE_REMOVE) {
+            uart_bt_send(rule_engine_remove(parsed.index) == 0 ? "OK: Rule removed\r\n"
+                                                               : "ERROR: No such rule\r\n");
+        } else {
+            rule_engine_clear();
+            uart_bt_send("OK: Rules cleared\r\n");
+        }
+        adjust_manager_update_actuators();
+        return;
+
+    case PARSER_ACTION_QUERY_PERCENTILE:
+    case PARSER_ACTION_QUERY_BELOW:
+        uart_bt_send_quantile(&parsed);
+        return;
+
+    case PARSER_ACTION_QUERY_TRACE:
+        uart_bt_send_trace();
+        return;
+
+    case PARSER_ACTION_SET_TRACE:
+        trace_enable(parsed.enable);
+        uart_bt_send(parsed.enable ? "OK: Trace on\r\n" : "OK: Trace off\r\n");
+        return;
+
+    case PARSER_ACTION_TRACE_CLEAR:
+        trace_clear();
+        uart_bt_send("OK: Trace cleared\r\n");
+        return;
+
+    case PARSER_ACTION_TRACE_DUMP:
+        trace_dump(uart_bt_send);
+        return;
+
+    default:
+        uart_bt_send("ERROR: Invalid command\r\n");
+        return;
+    }
+
+    /* Apply the action */
+    int rc = adjust_manager_process_action(
+        new_mode,
+        &parsed.new_setpoints,
+        apply_setpoints,
+        change_mode,
+        rx_line_cycles
+    );
+
+    /* Send confirmation */
+    if (rc == -EPERM) {
+        uart_bt_send("ERROR: Mode is READ\r\n");
+    }
+    else if (rc != 0) {
+        uart_bt_send("ERROR: Out of range\r\n");
+    }
+    else if (apply_setpoints) {
+        char response[80];
+        snprintf(response, sizeof(response),
+                "OK: T=%.1f H=%.1f L=%.1f\r\n",
+                (double)parsed.new_setpoints.target_temperature,
+                (double)parsed.new_setpoints.target_humidity,
+                (double)parsed.new_setpoints.target_light);
+        uart_bt_send(response);
+    }
+    else if (change_mode) {
+        uart_bt_send("OK: Mode changed\r\n");
+    }
+}
+
+void uart_bt_start(void)
+{
     uart_bt_send("\r\n=== Greenhouse Control System ===\r\n");
     uart_bt_send("Commands:\r\n");
     uart_bt_send("  TEMP=25,HUM=60,LUX=400\r\n");
     uart_bt_send("  MODE=READ\r\n");
     uart_bt_send("  MODE=ADJUST\r\n");
+    uart_bt_send("  STATS=TEMP,1H  (1M=this minute, 1H/24H/7D)\r\n");
+    uart_bt_send("  PCT=HUM,95  BELOW=HUM,60\r\n");
+    uart_bt_send("  HEALTH  TIMING  USAGE\r\n");
+    uart_bt_send("  TREND  FF=ON|OFF\r\n");
+    uart_bt_send("  PID  PID=ON|OFF  PID=20,0.05,30\r\n");
+    uart_bt_send("  TUNE  TUNE=FAN|PUMP|STOP\r\n");
+    uart_bt_send("  IRR  IRR=TP|ONOFF  COORD  COORD=ON|OFF\r\n");
+    uart_bt_send("  SCHED  SCHED=ON|OFF|CLR  SCHED+=06:00,24,65,400\r\n");
+    uart_bt_send("  CLOCK=14:30\r\n");
+    uart_bt_send("  RULES  RULE=CLR  RULE-=0\r\n");
+    uart_bt_send("  RULE+=IF TEMP>30 AND HUM<40 THEN PUMP ON FOR 5M\r\n");
+    uart_bt_send("  TRACE  TRACE=ON|OFF|CLR|DUMP\r\n");
+}
 
-    char cmd_buffer[BT_RX_BUF_SIZE];
+int uart_bt_inject(const char *line)
+{
+    uint32_t len = strnlen(line, BT_RX_BUF_SIZE - 1);
+    int ret = -ENOSPC;
 
-    while (1) {
+    k_spinlock_key_t key = k_spin_lock(&rx_lock);
+    if (ring_buf_space_get(&bt_rx_ring) > len) {
+        ring_buf_put(&bt_rx_ring, (const uint8_t *)line, len);
+        ring_buf_put(&bt_rx_ring, (const uint8_t *)"\n", 1);
+        rx_stamp_wake_locked();
+        ret = 0;
+    }
+    k_spin_unlock(&rx_lock, key);
 
-        /* Wait for a valid line of text */
-        if (k_msgq_get(&bt_rx_msgq, cmd_buffer, K_FOREVER) == 0) {
+    k_poll_signal_raise(&bt_rx_signal, 0);
+    return ret;
+}
 
-            /* Read the current setpoints */
-            env_setpoints_t current_sp;
-            k_mutex_lock(&env.lock, K_FOREVER);
-            current_sp = env.setpoints;
-            k_mutex_unlock(&env.lock);
+/* Handles one framed line, or drops the tail of an overlong one */
+static void uart_bt_rx_line(char *line, uint32_t len)
+{
+    if (rx_discarding) {
+        rx_discarding = false;
+    } else if (len > 0) {
+        rx_lines++;
+        LOG_DBG("Received: %s", line);
+        uart_bt_handle_command(line);
+    }
+}
 
-            /* Parse command using the NEW parser */
-            parser_result_t parsed =
-                command_parser_parse(cmd_buffer, &current_sp);
+/* Frames and runs the complete lines in the ring. A line lying in one
+ * stretch of the ring is terminated and handled where it is; only one
+ * wrapping around the end is copied out. A partial line stays in the
+ * ring until its terminator arrives. */
+static void uart_bt_rx_lines(void)
+{
+    uint8_t *data;
+    uint32_t len;
 
-            bool apply_setpoints = false;
-            bool change_mode = false;
-            env_mode_t new_mode = env.mode;
+    while ((len = ring_buf_get_claim(&bt_rx_ring, &data, BT_RX_RING_SIZE)) > 0) {
+        uint32_t end = 0;
 
-            /* Interpret parser output */
-            switch (parsed.action) {
+        while (end < len && data[end] != '\n' && data[end] != '\r' &&
+               end < BT_RX_BUF_SIZE - 1) {
+            end++;
+        }
 
-            case PARSER_ACTION_SET_SETPOINTS:
-                apply_setpoints = true;
-                break;
+        if (end < len && (data[end] == '\n' || data[end] == '\r')) {
+            data[end] = '\0';
+            uart_bt_rx_line((char *)data, end);
+            ring_buf_get_finish(&bt_rx_ring, end + 1);
+            continue;
+        }
 
-            case PARSER_ACTION_MODE_READ:
-                new_mode = ENV_MODE_READ_ONLY;
-                change_mode = true;
-                break;
+        if (end < len) {
+            /* Too long for any command: drop up to its terminator */
+            ring_buf_get_finish(&bt_rx_ring, end);
+            if (!rx_discarding) {
+                rx_too_long++;
+                rx_discarding = true;
+            }
+            continue;
+        }
 
-            case PARSER_ACTION_MODE_ADJUST:
-                new_mode = ENV_MODE_ADJUSTING;
-                change_mode = true;
-                break;
+        /* No terminator before the end of this stretch */
+        ring_buf_get_finish(&bt_rx_ring, 0);
+        if (ring_buf_size_get(&bt_rx_ring) == len) {
+            break;      /* Partial line, wait for the rest */
+        }
 
-            default:
-                uart_bt_send("ERROR: Invalid command\r\n");
-                continue;
-            }
+        /* The line wraps around the end of the ring */
+        char line[BT_RX_BUF_SIZE];
+        uint32_t n = ring_buf_peek(&bt_rx_ring, (uint8_t *)line, sizeof(line));
 
-            /* Apply the action */
-            adjust_manager_process_action(
-                new_mode,
-                &parsed.new_setpoints,
-                apply_setpoints,
-                change_mode
-            );
-
-            /* Send confirmation */
-            if (apply_setpoints) {
-                char response[80];
-                snprintf(response, sizeof(response),
-                        "OK: T=%.1f H=%.1f L=%.1f\r\n",
-                        (double)parsed.new_setpoints.target_temperature,
-                        (double)parsed.new_setpoints.target_humidity,
-                        (double)parsed.new_setpoints.target_light);
-                uart_bt_send(response);
+        for (end = len; end < n && line[end] != '\n' && line[end] != '\r'; end++) {
+        }
+        if (end == n) {
+            if (n < sizeof(line)) {
+                break;  /* Partial line, wait for the rest */
             }
-            else if (change_mode) {
-                uart_bt_send("OK: Mode changed\r\n");
+            ring_buf_get(&bt_rx_ring, NULL, n);
+            if (!rx_discarding) {
+                rx_too_long++;
+                rx_discarding = true;
             }
+            continue;
+        }
+        line[end] = '\0';
+        uart_bt_rx_line(line, end);
+        ring_buf_get(&bt_rx_ring, NULL, end + 1);
+    }
+}
+
+void uart_bt_init_poll_events(struct k_poll_event *events)
+{
+    k_poll_event_init(&events[0], K_POLL_TYPE_SIGNAL,
+                      K_POLL_MODE_NOTIFY_ONLY, &bt_rx_signal);
+    k_poll_event_init(&events[1], K_POLL_TYPE_SIGNAL,
+                      K_POLL_MODE_NOTIFY_ONLY, &bt_notify_signal);
+}
+
+void uart_bt_process(struct k_poll_event *events)
+{
+    if (events[1].state == K_POLL_STATE_SIGNALED) {
+        k_poll_signal_reset(&bt_notify_signal);
+        uart_bt_send_notifications();
+    }
+
+    /* Reset before framing: bytes arriving meanwhile raise it again */
+    if (events[0].state == K_POLL_STATE_SIGNALED) {
+        k_poll_signal_reset(&bt_rx_signal);
+
+        k_spinlock_key_t key = k_spin_lock(&rx_lock);
+        bool stamped = rx_wake_pending;
+        uint32_t wake_cycles = rx_wake_cycles;
+
+        rx_wake_pending = false;
+        k_spin_unlock(&rx_lock, key);
+
+        /* Line-to-handler latency, coalesced lines count as one */
+        if (stamped) {
+            app_channels_note_event_latency(wake_cycles);
         }
+        rx_line_cycles = stamped ? wake_cycles : k_cycle_get_32();
 
-        k_msleep(10);
+        uart_bt_rx_lines();
     }
 
+    events[0].state = K_POLL_STATE_NOT_READY;
+    events[1].state = K_POLL_STATE_NOT_READY;
+}
+
+/* Main Bluetooth thread */
+void uart_bt_thread(void *p1, void *p2, void *p3)
+{
+    struct k_poll_event events[UART_BT_POLL_EVENTS];
+
+    uart_bt_init();
+    uart_bt_start();
+    uart_bt_init_poll_events(events);
+
+    while (1) {
+        /* Sleep until a command line arrives or there is news to send */
+        k_poll(events, ARRAY_SIZE(events), K_FOREVER);
+        uart_bt_process(events);
+    }
 }
@@ -6,6 +6,20 @@
 /* Initializes UART and starts the Bluetooth interface */
 int uart_bt_init(void);
 
+/* Sends the command banner (after uart_bt_init) */
+void uart_bt_start(void);
+
+/* Poll events for received commands and pending notifications, and
+ * their handler (used by the thread below or by the reactor) */
+#define UART_BT_POLL_EVENTS  2
+void uart_bt_init_poll_events(struct k_poll_event *events);
+void uart_bt_process(struct k_poll_event *events);
+
+/* Queues a command line as if it had been received (trace replay).
+ * It goes straight into the RX ring: framing and dispatch run, but
+ * neither the interrupt nor the async UART path does. */
+int uart_bt_inject(const char *line);
+
 /* UART thread loops reading messages and dispatching actions */
 void uart_bt_thread(void *p1, void *p2, void *p3);
 